@@ -0,0 +1,141 @@
+#include "Affinity.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <pthread.h>
+#include <sched.h>
+
+bool cpuListParse(const std::string &text, std::vector<int> &cpus)
+{
+    std::vector<int> parsed;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        int first = 0;
+        int last = 0;
+        char dash = 0;
+        std::stringstream range(item);
+        if (!(range >> first) || first < 0)
+        {
+            return false;
+        }
+        last = first;
+        if (range >> dash && (dash != '-' || !(range >> last) || last < first))
+        {
+            return false;
+        }
+        if (last >= CPU_SETSIZE)
+        {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            parsed.push_back(cpu);
+        }
+    }
+
+    if (parsed.empty())
+    {
+        return false;
+    }
+    std::sort(parsed.begin(), parsed.end());
+    parsed.erase(std::unique(parsed.begin(), parsed.end()), parsed.end());
+    cpus = std::move(parsed);
+    return true;
+}
+
+std::string cpuListFormat(const std::vector<int> &cpus)
+{
+    std::ostringstream text;
+    for (size_t i = 0; i < cpus.size(); ++i)
+    {
+        // Find the end of a run of consecutive cores
+        size_t end = i;
+        while (end + 1 < cpus.size() && cpus[end + 1] == cpus[end] + 1)
+        {
+            ++end;
+        }
+
+        text << (i > 0 ? "," : "") << cpus[i];
+        if (end > i)
+        {
+            text << "-" << cpus[end];
+        }
+        i = end;
+    }
+    return text.str();
+}
+
+bool numaNodeCpus(int node, std::vector<int> &cpus)
+{
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string text;
+    if (node < 0 || !std::getline(file, text))
+    {
+        return false;
+    }
+    return cpuListParse(text, cpus);
+}
+
+AffinityLayout affinityForCpus(const std::vector<int> &cpus)
+{
+    AffinityLayout layout;
+
+    // Too few cores to give the stages their own, keep everything on the set
+    if (cpus.size() < 4)
+    {
+        layout.reader = cpus;
+        layout.tracker = cpus;
+        layout.output = cpus;
+        layout.pool = cpus;
+        return layout;
+    }
+
+    layout.reader = {cpus[0]};
+    layout.output = {cpus[1]};
+    layout.pool.assign(cpus.begin() + 2, cpus.end());
+    layout.tracker = layout.pool;
+    return layout;
+}
+
+std::vector<int> affinityCpus(const AffinityLayout &layout)
+{
+    std::vector<int> cpus;
+    for (const std::vector<int> *part : {&layout.reader, &layout.tracker, &layout.output, &layout.pool})
+    {
+        cpus.insert(cpus.end(), part->begin(), part->end());
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+bool threadPin(std::thread::native_handle_type thread, const std::vector<int> &cpus)
+{
+    if (cpus.empty())
+    {
+        return true;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+    {
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+}
+
+std::string affinityDescribe(const AffinityLayout &layout)
+{
+    auto describe = [](const std::vector<int> &cpus)
+    {
+        return cpus.empty() ? std::string("any") : cpuListFormat(cpus);
+    };
+
+    return "reader " + describe(layout.reader) + ", tracker " + describe(layout.tracker) + ", output " +
+           describe(layout.output) + ", pool " + describe(layout.pool);
+}
@@ -0,0 +1,43 @@
+#ifndef AFFINITY
+#define AFFINITY
+
+#include <string>
+#include <thread>
+#include <vector>
+
+// Cores each part of the pipeline is pinned to, an empty list leaves it floating
+struct AffinityLayout
+{
+    std::vector<int> reader;
+    std::vector<int> tracker;
+    std::vector<int> output;
+    std::vector<int> pool;
+};
+
+// Parse a Linux cpulist such as "0-3,8,10-11" into sorted, unique core numbers
+// Returns true if successful, false otherwise
+bool cpuListParse(const std::string &text, std::vector<int> &cpus);
+
+// Format core numbers as a cpulist, ranges are collapsed
+std::string cpuListFormat(const std::vector<int> &cpus);
+
+// Get the cores of a NUMA node from sysfs
+// Returns true if successful, false if the node does not exist
+bool numaNodeCpus(int node, std::vector<int> &cpus);
+
+// Lay the pipeline out on the cores of one NUMA node, so frames are handed off within a socket
+// The reader and output stages get a core each, the tracker stage shares the pool's cores
+AffinityLayout affinityForCpus(const std::vector<int> &cpus);
+
+// Get every core the layout places a part on, sorted and unique
+// Empty if nothing is pinned
+std::vector<int> affinityCpus(const AffinityLayout &layout);
+
+// Pin a thread to the cores, an empty list does nothing
+// Returns true if successful, false otherwise
+bool threadPin(std::thread::native_handle_type thread, const std::vector<int> &cpus);
+
+// One line description of the layout for the log
+std::string affinityDescribe(const AffinityLayout &layout);
+
+#endif
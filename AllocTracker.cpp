@@ -0,0 +1,268 @@
+#include "AllocTracker.h"
+
+#ifdef ENABLE_ALLOC_TRACKING
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <ostream>
+
+#include "opencv2/core.hpp"
+
+static constexpr size_t sAllocStages{static_cast<size_t>(AllocStage::Count)};
+
+// Counters of one stage, bumped by any thread charged to it
+struct AllocCounters
+{
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> matAllocations{0};
+    std::atomic<uint64_t> matBytes{0};
+    std::atomic<uint64_t> frames{0};
+};
+
+// Counters of one stage at the end of its warm-up
+struct AllocSnapshot
+{
+    uint64_t allocations{0};
+    uint64_t bytes{0};
+    uint64_t matAllocations{0};
+    uint64_t matBytes{0};
+    uint64_t frames{0};
+    bool taken{false};
+};
+
+static std::array<AllocCounters, sAllocStages> stageCounters;
+static std::array<AllocSnapshot, sAllocStages> stageWarm;
+static thread_local AllocStage threadStage{AllocStage::Other};
+
+static AllocCounters &countersOf(AllocStage stage)
+{
+    return stageCounters[static_cast<size_t>(stage)];
+}
+
+// Count a heap allocation of the calling thread, relaxed as only the totals matter
+static void countAllocation(size_t bytes)
+{
+    AllocCounters &counters = countersOf(threadStage);
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+static void *allocCounted(size_t bytes)
+{
+    countAllocation(bytes);
+    return std::malloc(bytes == 0 ? 1 : bytes);
+}
+
+static void *allocCountedAligned(size_t bytes, std::align_val_t align)
+{
+    countAllocation(bytes);
+    size_t alignment = static_cast<size_t>(align);
+    // aligned_alloc wants a multiple of the alignment
+    size_t rounded = (bytes + alignment - 1) / alignment * alignment;
+    return std::aligned_alloc(alignment, rounded == 0 ? alignment : rounded);
+}
+
+// Wraps OpenCV's standard allocator to count the Mat buffers it hands out
+class CountingMatAllocator : public cv::MatAllocator
+{
+private:
+    cv::MatAllocator *mBase{cv::Mat::getStdAllocator()};
+
+public:
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override
+    {
+        cv::UMatData *u = mBase->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        if (u)
+        {
+            // Release comes back here, and is passed on to the standard allocator
+            u->currAllocator = this;
+            if (!data)
+            {
+                AllocCounters &counters = countersOf(threadStage);
+                counters.matAllocations.fetch_add(1, std::memory_order_relaxed);
+                counters.matBytes.fetch_add(u->size, std::memory_order_relaxed);
+            }
+        }
+        return u;
+    }
+
+    bool allocate(cv::UMatData *data, cv::AccessFlag accessflags, cv::UMatUsageFlags usageFlags) const override
+    {
+        return mBase->allocate(data, accessflags, usageFlags);
+    }
+
+    void deallocate(cv::UMatData *data) const override
+    {
+        mBase->deallocate(data);
+    }
+};
+
+void allocStageSet(AllocStage stage)
+{
+    threadStage = stage;
+}
+
+void allocFrameDone(AllocStage stage)
+{
+    uint64_t frames = countersOf(stage).frames.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (frames != sAllocWarmupFrames)
+    {
+        return;
+    }
+
+    // The warm-up is over, from here on the stage should not allocate
+    // The pool works for the tracker stage, so its steady state starts with it
+    auto snapshot = [](AllocStage stage)
+    {
+        AllocCounters &counters = countersOf(stage);
+        AllocSnapshot &warm = stageWarm[static_cast<size_t>(stage)];
+        warm.allocations = counters.allocations.load(std::memory_order_relaxed);
+        warm.bytes = counters.bytes.load(std::memory_order_relaxed);
+        warm.matAllocations = counters.matAllocations.load(std::memory_order_relaxed);
+        warm.matBytes = counters.matBytes.load(std::memory_order_relaxed);
+        warm.frames = sAllocWarmupFrames;
+        warm.taken = true;
+    };
+    snapshot(stage);
+    if (stage == AllocStage::Tracker)
+    {
+        snapshot(AllocStage::Pool);
+    }
+}
+
+void allocTrackingStart()
+{
+    // Never destroyed, Mats released during shutdown still come back to it
+    // Constructed in malloc'd memory to stay out of its own counts
+    static CountingMatAllocator *allocator = new (std::malloc(sizeof(CountingMatAllocator))) CountingMatAllocator();
+    cv::Mat::setDefaultAllocator(allocator);
+
+    for (size_t i = 0; i < sAllocStages; ++i)
+    {
+        stageCounters[i].allocations.store(0);
+        stageCounters[i].bytes.store(0);
+        stageCounters[i].matAllocations.store(0);
+        stageCounters[i].matBytes.store(0);
+        stageCounters[i].frames.store(0);
+        stageWarm[i] = AllocSnapshot{};
+    }
+}
+
+AllocRate allocRateGet(AllocStage stage)
+{
+    AllocRate rate;
+    const AllocSnapshot &warm = stageWarm[static_cast<size_t>(stage)];
+    if (!warm.taken)
+    {
+        return rate;
+    }
+
+    const AllocCounters &counters = countersOf(stage);
+    AllocStage framesStage = stage == AllocStage::Pool ? AllocStage::Tracker : stage;
+    rate.frames = countersOf(framesStage).frames.load() - warm.frames;
+    if (rate.frames == 0)
+    {
+        return rate;
+    }
+
+    double frames = static_cast<double>(rate.frames);
+    rate.allocations = (counters.allocations.load() - warm.allocations) / frames;
+    rate.bytes = (counters.bytes.load() - warm.bytes) / frames;
+    rate.matAllocations = (counters.matAllocations.load() - warm.matAllocations) / frames;
+    rate.matBytes = (counters.matBytes.load() - warm.matBytes) / frames;
+    return rate;
+}
+
+void allocTrackingReport(std::ostream &out, double seconds)
+{
+    uint64_t shown = countersOf(AllocStage::Output).frames.load();
+    out << "Allocation tracking: " << shown << " frames output in " << std::fixed << std::setprecision(2) << seconds
+        << " s (" << (seconds > 0.0 ? shown / seconds : 0.0) << " fps)" << std::endl;
+
+    const char *names[] = {"other", "reader", "tracker", "output", "pool"};
+    for (size_t i = static_cast<size_t>(AllocStage::Reader); i < sAllocStages; ++i)
+    {
+        AllocRate rate = allocRateGet(static_cast<AllocStage>(i));
+        out << "  " << std::left << std::setw(8) << names[i] << std::right;
+        if (rate.frames == 0)
+        {
+            out << "fewer than " << sAllocWarmupFrames << " warm-up frames, no steady state" << std::endl;
+            continue;
+        }
+        out << rate.allocations << " allocations (" << rate.bytes << " B) and " << rate.matAllocations << " Mat buffers ("
+            << rate.matBytes << " B) per frame over " << rate.frames << " frames after the warm-up" << std::endl;
+    }
+    out << std::defaultfloat;
+}
+
+// Replaced global allocation functions, every variant goes through the counters
+
+void *operator new(std::size_t bytes)
+{
+    void *p = allocCounted(bytes);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](std::size_t bytes)
+{
+    return operator new(bytes);
+}
+
+void *operator new(std::size_t bytes, const std::nothrow_t &) noexcept
+{
+    return allocCounted(bytes);
+}
+
+void *operator new[](std::size_t bytes, const std::nothrow_t &) noexcept
+{
+    return allocCounted(bytes);
+}
+
+void *operator new(std::size_t bytes, std::align_val_t align)
+{
+    void *p = allocCountedAligned(bytes, align);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](std::size_t bytes, std::align_val_t align)
+{
+    return operator new(bytes, align);
+}
+
+void *operator new(std::size_t bytes, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    return allocCountedAligned(bytes, align);
+}
+
+void *operator new[](std::size_t bytes, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    return allocCountedAligned(bytes, align);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+
+#endif
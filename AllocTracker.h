@@ -0,0 +1,62 @@
+#ifndef ALLOC_TRACKER
+#define ALLOC_TRACKER
+
+#include <cstdint>
+#include <iosfwd>
+
+// Stages the heap allocations are charged to, by the thread that makes them
+enum class AllocStage
+{
+    Other,
+    Reader,
+    Tracker,
+    Output,
+    // Tracker updates on the pool, counted per frame of the tracker stage
+    Pool,
+    Count
+};
+
+// Frames each stage passes before its allocations count as steady state
+constexpr uint64_t sAllocWarmupFrames{30};
+
+// Allocations per frame of one stage after the warm-up
+// Mat buffers come from OpenCV's allocator, not operator new, so they are counted apart
+struct AllocRate
+{
+    double allocations{0.0};
+    double bytes{0.0};
+    double matAllocations{0.0};
+    double matBytes{0.0};
+    // Frames the rates are taken over
+    uint64_t frames{0};
+};
+
+#ifdef ENABLE_ALLOC_TRACKING
+
+constexpr bool sAllocTracking{true};
+
+// Charge the allocations of the calling thread to the stage
+void allocStageSet(AllocStage stage);
+// Count a frame passed on by the stage
+void allocFrameDone(AllocStage stage);
+// Reset the counters and count Mat buffers from now on
+void allocTrackingStart();
+// Allocations per frame of the stage after the warm-up
+AllocRate allocRateGet(AllocStage stage);
+// Print the steady-state allocations of every stage next to the output throughput
+void allocTrackingReport(std::ostream &out, double seconds);
+
+#else
+
+constexpr bool sAllocTracking{false};
+
+// Without ENABLE_ALLOC_TRACKING nothing is counted and these compile away
+inline void allocStageSet(AllocStage) {}
+inline void allocFrameDone(AllocStage) {}
+inline void allocTrackingStart() {}
+inline AllocRate allocRateGet(AllocStage) { return AllocRate{}; }
+inline void allocTrackingReport(std::ostream &, double) {}
+
+#endif
+
+#endif
@@ -1,16 +1,44 @@
 #ifndef CONTROL_NODE
 #define CONTROL_NODE
 
+#include "Affinity.h"
 #include "DataStructs.h"
+#include "FrameCache.h"
+#include "KeyframeIndex.h"
+#include "QosController.h"
+#include "RawVideo.h"
+#include "RingQueue.h"
+#include "SceneDetector.h"
+#include "ThreadBudget.h"
 #include "ThreadPool.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "opencv2/highgui.hpp"
 
-constexpr int sMaxThreads{16};
+// Frames the output hands back for the reader to decode into
+// More than the queues and the tracker window hold, so none are thrown away in steady state
+constexpr size_t sSpareFrames{32};
+// Spare frames hold at most this fraction of the frame memory budget, their bytes are not leased
+constexpr size_t sSpareBudgetDivisor{4};
+// Frames decoded in the background right after opening, while the UI comes up
+constexpr size_t sPrefetchFrames{4};
+
+// Properties of the opened video, read together
+struct CaptureInfo
+{
+    double fps{0.0};
+    int frames{0};
+    cv::Size size;
+};
 
 // Holds the state and synchronization primitives
 // for video processing across multiple threads
@@ -19,27 +47,110 @@ class ControlNode
 private:
     // Stop source for thread management
     std::stop_source mStopSource;
+    // Creation of the control node, the start of the time to the first shown frame
+    std::chrono::steady_clock::time_point mStartTime{std::chrono::steady_clock::now()};
+    std::atomic<bool> mFirstFrameShown{false};
 
-    // Video capture
+    // Video capture, or the raw reader for raw video files
     cv::VideoCapture mCap;
+    RawVideoReader mRawReader;
     mutable std::mutex mCapMutex;
+    // Live sources (devices, pipes) cannot seek and are read at their own pace
+    std::atomic<bool> mLive{false};
+    // Forced with capLiveSet, also for sources opened later, e.g. network streams
+    bool mLiveForced{false};
+    // Decoded videos deliver native frames and are tracked on their luma plane
+    std::atomic<bool> mLuma{false};
+    cv::Size mFrameSize;
+    // Frame rate of the opened video, read without taking the capture lock
+    std::atomic<double> mCapFps{0.0};
+
+    // Keyframes of the opened file, used for fast and exact seeks
+    KeyframeIndex mKeyframeIndex;
 
-    // Object trackers
-    std::vector<ObjectTracker> mTrackers;
+    // Optional disk cache of decoded frames, filled while decoding
+    // After a seek to a cached frame, reads are served from the cache until the
+    // first miss, then the decoder continues from there
+    FrameCache mFrameCache;
+    std::string mFrameCacheDirectory;
+    size_t mFrameCacheBytes{0};
+    int mCacheCursor{-1};
+
+    // First frames of a decoded video, decoded ahead in the background after opening
+    // They are read before the decoder, and dropped when the read position changes
+    RingQueue<Frame> mPrefetched{sPrefetchFrames};
+
+    // Frames the output is done with, the reader reuses their buffers
+    std::vector<Frame> mSpareFrames;
+    size_t mSpareBytes{0};
+    size_t mSpareBytesLimit{SIZE_MAX};
+    std::mutex mSpareFramesMutex;
+
+    // Object trackers, a deque so trackers being updated stay put when others are added
+    std::deque<ObjectTracker> mTrackers;
     mutable std::mutex mTrackersMutex;
+    // Generation the trackers' lost flags belong to
+    uint32_t mLostGeneration{0};
+
+    // Scene change detection, only used by the tracker stage
+    SceneDetector mSceneDetector;
 
     // Frame generation counter
     std::atomic<uint32_t> mGeneration{0};
 
+    // Scale of the displayed preview relative to the full resolution frame
+    std::atomic<double> mPreviewScale{1.0};
+    // Frames tracked on luma are only converted to BGR when something shows them
+    std::atomic<bool> mRender{true};
+
+    // What new trackers search in
+    std::atomic<SearchWindowMode> mSearchWindowMode{SearchWindowMode::Off};
+
+    // Tracking time per frame before remaining updates are deferred, 0 for unlimited
+    std::atomic<double> mTrackingBudgetMs{0.0};
+
+    // Quality of service, the controller is only used by the tracker stage
+    QosController mQos;
+    std::atomic<int> mUpdateStride{5};
+    std::atomic<int> mTrackerPatchArea{80 * 80};
+
     // Save control
     std::atomic<uint32_t> mSaveState{0};
     uint32_t mReturnIndex{0};
 
-    // Thread pool
-    ThreadPool mThreadPool;
+    // Division of the cores and the tracker pool sized by it
+    // The pool is created on first use, playback without trackers never starts its threads
+    ThreadBudget mThreadBudget;
+    std::unique_ptr<ThreadPool> mThreadPool;
+    std::atomic<ThreadPool *> mThreadPoolReady{nullptr};
+    std::mutex mThreadPoolMutex;
+    // Cores the stages and the pool are pinned to
+    AffinityLayout mAffinity;
+
+    // Seek the active source to a frame index, the capture mutex must be held
+    // Jumps to the nearest keyframe and grabs forward to the exact frame
+    bool capSeekLocked(int index);
+    // Seek the decoder to a frame index, the capture mutex must be held
+    bool capSeekDecoderLocked(int index);
+    // Read the next frame of a decoded video from the cache or the decoder
+    // The capture mutex must be held
+    bool capDecodeLocked(cv::Mat &image, int &index);
+    // Decode the next frame of a decoded video into the frame, the capture mutex must be held
+    bool capDecodeFrameLocked(Frame &frame);
+    // Open the frame cache for the decoded video, the capture mutex must be held
+    void frameCacheOpenLocked();
+
+    // Decodes the first frames after opening
+    // Declared last, so it is stopped before anything it reads is destroyed
+    std::jthread mPrefetcher;
 
 public:
-    ControlNode(cv::VideoCapture cap) : mCap(std::move(cap)), mThreadPool(sMaxThreads, mStopSource.get_token()) {}
+    ControlNode(cv::VideoCapture cap)
+        : mCap(std::move(cap)),
+          mThreadBudget(threadBudgetSplit(0, -1))
+    {
+        mSpareFrames.reserve(sSpareFrames);
+    }
     ~ControlNode() = default;
 
     // Delete copy and move constructors and assignment operators
@@ -52,6 +163,23 @@ public:
 
     // Returns a reference to the stop source for thread management
     std::stop_source &stopSourceGet() { return mStopSource; }
+    // Returns a reference to the worker pool shared by the pipeline stages
+    // The pool is created and pinned on the first call
+    ThreadPool &threadPoolGet();
+    // Mark a frame as shown, the first one reports the time since the control node was created
+    void firstFrameShown();
+    // Apply a division of the cores: size the pool, limit OpenCV's parallel backend
+    // and use the codec share for videos opened and writers created from now on
+    // Must be called before playback starts, an existing pool drops its queued jobs
+    void threadBudgetSet(const ThreadBudget &budget);
+    // Get the division of the cores
+    ThreadBudget threadBudgetGet() const;
+    // Pin the pool workers to the layout's pool cores now and after a resize
+    // The stages are pinned to their cores when they start
+    // Must be called before playback starts
+    void affinitySet(const AffinityLayout &layout);
+    // Get the cores the stages and the pool are pinned to
+    AffinityLayout affinityGet() const;
     // Wait until the generation is different from value
     void generationWait(uint32_t value) const;
     // Get the current generation value
@@ -60,10 +188,16 @@ public:
     // Capture functions
 
     // Open the video capture with the given filename
+    // Raw video files are memory-mapped instead of decoded
     // Returns true if successful, false otherwise
     bool capOpen(const cv::String &filename);
     // Check if the video capture is opened
     bool capIsOpened() const;
+    // Decode the first frames of the opened video in the background, reads take them first
+    // Raw videos and live sources are not read ahead
+    void capPrefetch(size_t frames);
+    // Get the frame rate, frame count and size of the opened video in one go
+    CaptureInfo capInfo() const;
     // Read the next frame from the video capture into the provided image
     // Returns true if successful, false otherwise
     bool capRead(cv::OutputArray image);
@@ -77,14 +211,55 @@ public:
     bool capReadAndGet(Frame &frame);
     // Release the video capture
     void capRelease();
+    // Hand back a frame the pipeline is done with, its buffers are decoded into again
+    void frameRecycle(Frame &&frame);
+    // Get a frame to read into, with the buffers of a recycled frame when there is one
+    Frame frameSpare();
+    // Limit the bytes kept by spare frames, frames beyond it are freed when handed back
+    void frameSpareLimitSet(size_t bytes);
+    // Check if the source is live: a device, a pipe or forced with capLiveSet
+    bool capIsLive() const;
+    // Get the frame rate of the opened video, 0 if unknown
+    double capFpsGet() const;
+    // Treat the source as live (or not), e.g. for network streams
+    // Set before opening, so the source is neither indexed nor read ahead
+    void capLiveSet(bool live);
+    // Have the decoder deliver native frames (YUV or gray) and track on their luma plane
+    // BGR is rendered only for frames that are shown or saved. Raw videos are always BGR.
+    void capLumaSet(bool luma);
+    // Check if decoded frames are tracked on luma
+    bool capIsLuma() const;
+    // Cache decoded frames in a file in the directory, using at most budgetBytes
+    // A budget of 0 disables the cache. Raw videos are never cached.
+    void frameCacheConfigure(const std::string &directory, size_t budgetBytes);
 
     // Tracker functions
 
     // Add new trackers and rewind to a specific frame index
     void trackersPushBackAndRewind(std::vector<ObjectTracker> &&trackers, int rewindIndex);
-    // Update all trackers with the given frame and draw their bounding boxes
-    // Returns true if the frame generation matched, false otherwise
-    bool trackersUpdateAndDraw(const Frame &frame);
+    // KCF parameters for images with the given number of channels and feature patch area
+    static cv::TrackerKCF::Params trackerParams(int channels, int patchArea);
+    // Get the feature patch area of the current quality level
+    int trackerPatchAreaGet() const;
+    // Create a tracker for each box, initializing them in parallel on the thread pool,
+    // then add them all at once and rewind to a specific frame index
+    // Boxes are clipped to the image, boxes outside it and trackers that fail to start are reported and skipped
+    void trackersCreateAndRewind(const cv::Mat &image, const std::vector<cv::Rect> &boxes, int rewindIndex);
+    // Plan what every tracker does with the given frame, must be called in frame order
+    // Detects scene changes and applies the update stride
+    // The steps are written to the given vector, so its capacity is reused from frame to frame
+    // No steps for frames of an old generation or without trackers
+    void trackersPlan(const Frame &frame, std::vector<TrackerStep> &steps);
+    // Called by a lost tracker's lane when its region looks as it did before the cut
+    // The tracker is updated again from the next planned frame on
+    void trackerFound(ObjectTracker &tracker, int id, int frameIdx);
+    // Set the tracking time per frame in ms, trackers that have not started by then
+    // keep their box and go first on the next frame. 0 for unlimited.
+    void trackingBudgetSet(double milliseconds);
+    // Get the tracking time per frame in ms, 0 for unlimited
+    double trackingBudgetGet() const;
+    // Set what trackers created from now on search in
+    void searchWindowModeSet(SearchWindowMode mode);
 
     // Output functions
 
@@ -94,6 +269,22 @@ public:
     void setIsSaving(uint32_t value, uint32_t returnIndex = 0);
     // Get the current saving state (1 if saving, 0 if not)
     bool isSaving() const;
+    // Set the scale of the displayed preview, clamped to (0, 1]
+    void previewScaleSet(double scale);
+    // Get the scale of the displayed preview
+    double previewScaleGet() const;
+    // Set whether every frame is shown or published, so frames tracked on luma need BGR
+    void renderSet(bool render);
+    // Check if every frame needs a BGR image
+    bool renderNeeded() const;
+
+    // Quality of service functions
+
+    // Set the bounds of the quality-of-service controller and apply full quality
+    void qosConfigure(const QosSettings &settings);
+    // Feed the latency and tracking load of a tracked frame to the controller
+    // Adjusts the update stride, preview scale and tracker patch size under load
+    void qosUpdate(double latencyMs, double load);
 };
 
 #endif
@@ -0,0 +1,132 @@
+#include "CropExporter.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <latch>
+
+#include "opencv2/imgproc.hpp"
+
+bool exportModeParse(const std::string &text, ExportMode &mode)
+{
+    if (text == "full")
+    {
+        mode = ExportMode::Full;
+    }
+    else if (text == "crops")
+    {
+        mode = ExportMode::Crops;
+    }
+    else if (text == "both")
+    {
+        mode = ExportMode::Both;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+CropExporter::CropExporter(const std::string &directory, const std::string &extension, int fourcc, double fps,
+                           int cropSize)
+    : mDirectory(directory), mExtension(extension), mFourcc(fourcc), mFps(fps > 0.0 ? fps : 30.0),
+      mCropSize(std::max(cropSize, 8))
+{
+}
+
+void CropExporter::exportFrame(const cv::Mat &image, const std::vector<TrackerResult> &results, ThreadPool &pool)
+{
+    // Count the objects to write before submitting any job
+    auto exported = [](const TrackerResult &result)
+    { return result.active && !result.box.empty(); };
+    auto count = std::count_if(results.begin(), results.end(), exported);
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Objects are independent, so their crops are cut and encoded at the same time
+    // Streams are created on this thread, each job only touches its own stream
+    std::latch written(count);
+    for (const auto &result : results)
+    {
+        if (!exported(result))
+        {
+            continue;
+        }
+
+        CropStream &stream = mStreams[result.id];
+        pool.submit([this, &image, &written, &stream, id = result.id, box = result.box]
+                    {
+                        if (stream.frames == 0 && !stream.failed)
+                        {
+                            stream.failed = !streamOpen(id, stream);
+                        }
+                        if (!stream.failed)
+                        {
+                            streamWrite(stream, image, box);
+                        }
+                        written.count_down(); });
+    }
+    written.wait();
+}
+
+void CropExporter::close()
+{
+    for (auto &[id, stream] : mStreams)
+    {
+        stream.writer.release();
+    }
+
+    if (!mStreams.empty())
+    {
+        std::cout << "Exported crops of " << mStreams.size() << " objects to " << mDirectory << std::endl;
+    }
+    mStreams.clear();
+}
+
+bool CropExporter::streamOpen(int id, CropStream &stream)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(mDirectory, ec);
+
+    std::string path = mDirectory + "/object_" + std::to_string(id) + mExtension;
+    if (!stream.writer.open(path, mFourcc, mFps, cv::Size(mCropSize, mCropSize)))
+    {
+        std::cerr << "Error: Could not open crop writer: " << path << std::endl;
+        return false;
+    }
+
+    // The streams are already encoded in parallel on the pool, one stripe each
+    stream.writer.set(cv::VIDEOWRITER_PROP_NSTRIPES, 1);
+    return true;
+}
+
+void CropExporter::streamWrite(CropStream &stream, const cv::Mat &image, const cv::Rect &box)
+{
+    cv::Point2f center(box.x + box.width * 0.5f, box.y + box.height * 0.5f);
+    float side = std::max(box.width, box.height) * sCropMargin;
+
+    // Smooth the window so tracker jitter does not shake the crop
+    if (stream.frames == 0)
+    {
+        stream.center = center;
+        stream.side = side;
+    }
+    else
+    {
+        stream.center += (center - stream.center) * sCropSmoothing;
+        stream.side += (side - stream.side) * sCropSmoothing;
+    }
+
+    // Map the window onto the output, parts outside the frame are black
+    float scale = mCropSize / stream.side;
+    cv::Mat transform = (cv::Mat_<double>(2, 3) << scale, 0.0, mCropSize * 0.5 - stream.center.x * scale,
+                         0.0, scale, mCropSize * 0.5 - stream.center.y * scale);
+    cv::Mat crop;
+    cv::warpAffine(image, crop, transform, cv::Size(mCropSize, mCropSize), cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+
+    stream.writer.write(crop);
+    stream.frames += 1;
+}
@@ -0,0 +1,76 @@
+#ifndef CROP_EXPORTER
+#define CROP_EXPORTER
+
+#include "DataStructs.h"
+#include "ThreadPool.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "opencv2/videoio.hpp"
+
+// What a save writes: the annotated full frames, one crop stream per object, or both
+enum class ExportMode
+{
+    Full,
+    Crops,
+    Both
+};
+
+// Parse "full", "crops" or "both"
+// Returns true if successful, false otherwise
+bool exportModeParse(const std::string &text, ExportMode &mode);
+
+// Weight of the newest box when smoothing the crop window
+constexpr float sCropSmoothing{0.2f};
+// Side of the crop window relative to the larger side of the box
+constexpr float sCropMargin{1.5f};
+
+// Writes a stabilised, fixed-size crop around every tracked object to its own video
+// The crops of one frame are cut and encoded in parallel on the worker pool
+class CropExporter
+{
+private:
+    // Video and smoothed window of one object
+    struct CropStream
+    {
+        cv::VideoWriter writer;
+        cv::Point2f center;
+        float side{0.0f};
+        int frames{0};
+        bool failed{false};
+    };
+
+    std::string mDirectory;
+    std::string mExtension;
+    int mFourcc;
+    double mFps;
+    int mCropSize;
+    // Streams by tracker id, map nodes stay put while jobs hold them
+    std::map<int, CropStream> mStreams;
+
+    // Open the video of a new object, returns false if it could not be created
+    bool streamOpen(int id, CropStream &stream);
+    // Move the window towards the box and write the crop of the clean frame
+    void streamWrite(CropStream &stream, const cv::Mat &image, const cv::Rect &box);
+
+public:
+    // Crops are cropSize x cropSize and written as <directory>/object_<id><extension>
+    CropExporter(const std::string &directory, const std::string &extension, int fourcc, double fps, int cropSize);
+    ~CropExporter() = default;
+
+    // Delete copy and move constructors and assignment operators
+    CropExporter(const CropExporter &) = delete;
+    CropExporter &operator=(const CropExporter &) = delete;
+    CropExporter(CropExporter &&) = delete;
+    CropExporter &operator=(CropExporter &&) = delete;
+
+    // Write the crop of every active object of the frame and wait until all are encoded
+    // The image must not have highlights drawn on it
+    void exportFrame(const cv::Mat &image, const std::vector<TrackerResult> &results, ThreadPool &pool);
+    // Finish all streams, the next export starts new files
+    void close();
+};
+
+#endif
@@ -1,15 +1,143 @@
 #ifndef DATA_STRUCTS
 #define DATA_STRUCTS
 
+#include "FrameBudget.h"
+#include "SceneDetector.h"
+
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
 #include "opencv2/highgui.hpp"
 #include "opencv2/tracking.hpp"
 
+// Result of one tracker for a single frame
+struct TrackerResult
+{
+    int id;
+    cv::Rect box;
+    bool active;
+    // Updates of this tracker skipped so far to keep frames within the time budget
+    int deferrals{0};
+};
+
+// Pixel layout of a frame as delivered by the decoder
+enum class NativeFormat
+{
+    Bgr,  // Already converted, e.g. when the backend ignores the request for native frames
+    Gray, // Luma only
+    I420, // Planar YUV 4:2:0, the Y plane followed by U and V
+    Yuyv  // Packed YUV 4:2:2
+};
+
 // Frame structure to hold image and metadata
 struct Frame
 {
     int idx;
     uint32_t generation;
+    // BGR image for display and output, rendered from native on demand when tracking on luma
     cv::Mat image;
+    // Decoder output when tracking on luma, empty otherwise and for BGR decoder output
+    cv::Mat native;
+    NativeFormat nativeFormat{NativeFormat::Bgr};
+    // Luma plane the trackers work on, usually a view into native
+    // Empty when the trackers work on the BGR image
+    cv::Mat luma;
+    // Downscaled copy of the image for display, empty when shown at full size
+    cv::Mat preview;
+    // Time the frame was read from the capture, used for latency measurements
+    std::chrono::steady_clock::time_point readTime;
+    // Tracker boxes for this frame, filled in by the tracker stage
+    std::vector<TrackerResult> results;
+    // Reservation of the frame's bytes in the in-flight memory budget
+    std::shared_ptr<FrameBudget::Lease> lease;
+    // Keeps external memory behind the image (e.g. a file mapping) alive
+    std::shared_ptr<void> storage;
+};
+
+// Check that no cv::Mat outside the frame shares one of the frame's buffers
+// The frame's own Mats may share a buffer, e.g. a luma view into the native frame
+// Images that wrap external memory have no reference count and always pass
+inline bool frameOwnsBuffers(const Frame &frame)
+{
+    const cv::Mat *mats[] = {&frame.image, &frame.native, &frame.luma, &frame.preview};
+    for (const cv::Mat *mat : mats)
+    {
+        if (mat->u == nullptr)
+        {
+            continue;
+        }
+        int references = 0;
+        for (const cv::Mat *other : mats)
+        {
+            references += other->u == mat->u ? 1 : 0;
+        }
+        if (mat->u->refcount != references)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Give a frame that wraps external memory (a read-only file mapping) its own copy of the image
+// Needed before drawing into it, frames that are only shown or tracked keep pointing at the mapping
+inline void frameImageWritable(Frame &frame)
+{
+    if (frame.image.u == nullptr && !frame.image.empty())
+    {
+        frame.image = frame.image.clone();
+        frame.storage.reset();
+    }
+}
+
+// Bytes held by the frame's pixel buffers, a buffer shared by several of its Mats counts once
+inline size_t frameBytes(const Frame &frame)
+{
+    const cv::Mat *mats[] = {&frame.image, &frame.native, &frame.luma, &frame.preview};
+    size_t bytes = 0;
+    for (size_t i = 0; i < std::size(mats); ++i)
+    {
+        bool shared = false;
+        for (size_t j = 0; j < i; ++j)
+        {
+            shared = shared || (mats[i]->u != nullptr && mats[i]->u == mats[j]->u);
+        }
+        bytes += shared ? 0 : mats[i]->total() * mats[i]->elemSize();
+    }
+    return bytes;
+}
+
+// Charge the frame's lease for buffers added after decoding, e.g. the BGR image of a luma frame or the preview
+// Never waits, the reader makes up for it before decoding the next frame
+inline void frameLeaseUpdate(Frame &frame)
+{
+    if (frame.lease)
+    {
+        frame.lease->resize(frameBytes(frame));
+    }
+}
+
+// Check if the frame has no pixels, which marks the end of the video
+inline bool frameEmpty(const Frame &frame)
+{
+    return frame.image.empty() && frame.native.empty();
+}
+
+// Image the trackers and the scene detector work on
+inline const cv::Mat &frameTrackingImage(const Frame &frame)
+{
+    return frame.luma.empty() ? frame.image : frame.luma;
+}
+
+// What a tracker is given to search in
+enum class SearchWindowMode
+{
+    Off,   // The whole frame
+    View,  // A padded window around the box, viewed in place in the frame
+    Gather // The same window, copied into a contiguous buffer first
 };
 
 // Object tracker structure to hold tracker instance and bounding box
@@ -17,7 +145,38 @@ struct ObjectTracker
 {
     cv::Ptr<cv::Tracker> tracker;
     cv::Rect box;
+    // Search window in frame coordinates, the tracker itself works inside it
+    SearchWindowMode mode{SearchWindowMode::Off};
+    cv::Rect window;
+    cv::Mat windowBuffer;
     bool active{true};
+    // KCF patch area the tracker was initialized with
+    int patchArea{0};
+    // Set when the scene cut away from the object, lost trackers are no longer updated
+    // Cleared when the video is rewound or seeks, which may go back to before the cut,
+    // or when the region of the last box looks as it did before the cut again
+    bool lost{false};
+    // Frame index of the cut that lost the tracker
+    int lostAt{-1};
+    // Region around the box at the last update, only touched by the tracker's lane
+    RegionDetector region;
+};
+
+// What a tracker does with one frame
+enum class TrackerAction
+{
+    Update, // Run the tracker on the frame
+    Reuse,  // Keep the previous box
+    Lose    // The object is gone, mark the tracker inactive
+};
+
+// Work of one tracker on one frame, planned in frame order by the tracker stage
+// Only the tracker's own lane touches its box and active flag
+struct TrackerStep
+{
+    ObjectTracker *tracker;
+    int id;
+    TrackerAction action;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,128 @@
+#ifndef FRAME_BUDGET
+#define FRAME_BUDGET
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+
+// Limits the number of bytes held by decoded frames in flight
+// Frames hold a lease on their bytes until the last copy is destroyed
+class FrameBudget : public std::enable_shared_from_this<FrameBudget>
+{
+public:
+    // Bytes reserved for one frame, returned to the budget on destruction
+    class Lease
+    {
+        friend class FrameBudget;
+
+    private:
+        std::shared_ptr<FrameBudget> mBudget;
+        size_t mBytes;
+
+    public:
+        Lease(std::shared_ptr<FrameBudget> budget, size_t bytes)
+            : mBudget(std::move(budget)), mBytes(bytes) {}
+        ~Lease() { mBudget->release(mBytes); }
+
+        // Delete copy and move constructors and assignment operators
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        Lease(Lease &&) = delete;
+        Lease &operator=(Lease &&) = delete;
+
+        // Change the number of reserved bytes without waiting
+        // Used once the real size of a frame is known
+        void resize(size_t bytes)
+        {
+            mBudget->adjust(mBytes, bytes);
+            mBytes = bytes;
+        }
+    };
+
+private:
+    mutable std::mutex mMutex;
+    std::condition_variable_any mReleasedCv;
+    size_t mCapacity;
+    size_t mInFlight{0};
+    size_t mPeak{0};
+
+    // Change the bytes in flight from oldBytes to newBytes
+    void adjust(size_t oldBytes, size_t newBytes)
+    {
+        {
+            std::scoped_lock lock(mMutex);
+            mInFlight = mInFlight - oldBytes + newBytes;
+            mPeak = std::max(mPeak, mInFlight);
+        }
+
+        if (newBytes < oldBytes)
+        {
+            mReleasedCv.notify_all();
+        }
+    }
+
+    // Return bytes to the budget and wake a waiting reader
+    void release(size_t bytes)
+    {
+        adjust(bytes, 0);
+    }
+
+public:
+    // Constructor with the budget capacity in bytes
+    FrameBudget(size_t capacity) : mCapacity(capacity) {}
+    // Delete copy and move constructors and assignment operators
+    FrameBudget(const FrameBudget &) = delete;
+    FrameBudget &operator=(const FrameBudget &) = delete;
+    FrameBudget(FrameBudget &&) = delete;
+    FrameBudget &operator=(FrameBudget &&) = delete;
+
+    // Wait until the given bytes fit in the budget and reserve them on the lease
+    // A frame larger than the whole budget is admitted when nothing else is in flight
+    // The emptied lease of a recycled frame is reused, otherwise a new one is made
+    // If the stop token is triggered while waiting, returns false and leaves the lease alone
+    bool acquire(std::shared_ptr<Lease> &lease, size_t bytes, std::stop_token st)
+    {
+        {
+            std::unique_lock lock(mMutex);
+            if (!mReleasedCv.wait(lock, st, [this, bytes]
+                                  { return mInFlight == 0 || mInFlight + bytes <= mCapacity; }))
+            {
+                // Woken by stop token
+                return false;
+            }
+
+            mInFlight += bytes;
+            mPeak = std::max(mPeak, mInFlight);
+        }
+
+        if (lease && lease.use_count() == 1 && lease->mBudget.get() == this && lease->mBytes == 0)
+        {
+            lease->mBytes = bytes;
+        }
+        else
+        {
+            lease = std::make_shared<Lease>(shared_from_this(), bytes);
+        }
+        return true;
+    }
+
+    // Get the budget capacity in bytes
+    size_t capacityGet() const { return mCapacity; }
+    // Get the bytes currently held by frames in flight
+    size_t inFlightGet() const
+    {
+        std::scoped_lock lock(mMutex);
+        return mInFlight;
+    }
+    // Get the highest number of bytes held by frames in flight
+    size_t peakGet() const
+    {
+        std::scoped_lock lock(mMutex);
+        return mPeak;
+    }
+};
+
+#endif
@@ -0,0 +1,195 @@
+#include "FrameCache.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+bool FrameCache::open(const std::string &directory, cv::Size frameSize, size_t budgetBytes)
+{
+    close();
+
+    if (frameSize.width <= 0 || frameSize.height <= 0)
+    {
+        return false;
+    }
+
+    // Frames start on page boundaries like in raw videos
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t frameBytes = size_t(frameSize.width) * frameSize.height * 3;
+    size_t frameStride = (frameBytes + pageSize - 1) / pageSize * pageSize;
+    size_t slotBytes = frameStride * sFrameCacheSegmentFrames;
+    size_t slotCount = budgetBytes / slotBytes;
+    size_t size = slotBytes * slotCount;
+
+    // The budget is a bound, a cache that does not fit a single segment is not created
+    if (slotCount == 0)
+    {
+        std::cerr << "Frame cache: a segment of " << sFrameCacheSegmentFrames << " frames needs "
+                  << (slotBytes + 1024 * 1024 - 1) / (1024 * 1024) << " MB, more than the budget of "
+                  << budgetBytes / (1024 * 1024) << " MB" << std::endl;
+        return false;
+    }
+
+    // The file is unlinked right away so it disappears with the mapping
+    std::string path = (directory.empty() ? std::string(".") : directory) + "/ohcache-XXXXXX";
+    int fd = mkstemp(path.data());
+    if (fd < 0)
+    {
+        return false;
+    }
+    unlink(path.c_str());
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // Shared mapping: the kernel writes frames back to the file, not to swap
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    {
+        std::scoped_lock lock(mMutex);
+        mData = static_cast<uint8_t *>(data);
+        mSize = size;
+        mFrameSize = frameSize;
+        mFrameStride = frameStride;
+        mSlots.assign(slotCount, Slot{});
+    }
+
+    std::cout << "Frame cache: " << slotCount * sFrameCacheSegmentFrames << " frames in " << size / (1024 * 1024)
+              << " MB" << std::endl;
+    return true;
+}
+
+void FrameCache::close()
+{
+    std::scoped_lock lock(mMutex);
+    if (mData != nullptr)
+    {
+        munmap(mData, mSize);
+    }
+    mData = nullptr;
+    mSize = 0;
+    mSlots.clear();
+    mSegmentSlots.clear();
+    mLru.clear();
+}
+
+bool FrameCache::isOpened() const
+{
+    std::scoped_lock lock(mMutex);
+    return mData != nullptr;
+}
+
+void FrameCache::store(int index, const cv::Mat &image)
+{
+    int segment = index / sFrameCacheSegmentFrames;
+    int offset = index % sFrameCacheSegmentFrames;
+    int slot = -1;
+    {
+        std::scoped_lock lock(mMutex);
+        if (mData == nullptr || index < 0 || image.size() != mFrameSize || image.type() != CV_8UC3)
+        {
+            return;
+        }
+
+        // Never overwrite a frame a reader may be copying
+        slot = slotAcquireLocked(segment);
+        if (mSlots[slot].valid[offset])
+        {
+            return;
+        }
+    }
+
+    // Only the storing thread acquires slots, and the frame is not valid yet, so no reader touches it
+    uint8_t *dst = framePtr(slot, offset);
+    size_t rowBytes = image.cols * image.elemSize();
+    for (int r = 0; r < image.rows; ++r)
+    {
+        std::memcpy(dst + r * rowBytes, image.ptr(r), rowBytes);
+    }
+
+    std::scoped_lock lock(mMutex);
+    mSlots[slot].valid[offset] = true;
+}
+
+bool FrameCache::contains(int index) const
+{
+    std::scoped_lock lock(mMutex);
+
+    auto it = mSegmentSlots.find(index / sFrameCacheSegmentFrames);
+    return index >= 0 && it != mSegmentSlots.end() && mSlots[it->second].valid[index % sFrameCacheSegmentFrames];
+}
+
+bool FrameCache::load(int index, cv::Mat &image)
+{
+    std::scoped_lock lock(mMutex);
+
+    int segment = index / sFrameCacheSegmentFrames;
+    auto it = mSegmentSlots.find(segment);
+    if (index < 0 || it == mSegmentSlots.end() || !mSlots[it->second].valid[index % sFrameCacheSegmentFrames])
+    {
+        return false;
+    }
+    touchLocked(segment);
+
+    // Copy under the lock, so the slot cannot be evicted meanwhile
+    cv::Mat cached(mFrameSize, CV_8UC3, framePtr(it->second, index % sFrameCacheSegmentFrames));
+    cached.copyTo(image);
+    return true;
+}
+
+int FrameCache::slotAcquireLocked(int segment)
+{
+    auto it = mSegmentSlots.find(segment);
+    if (it != mSegmentSlots.end())
+    {
+        touchLocked(segment);
+        return it->second;
+    }
+
+    // Take a free slot, or the one of the least recently used segment
+    int slot = -1;
+    if (mSegmentSlots.size() < mSlots.size())
+    {
+        slot = static_cast<int>(mSegmentSlots.size());
+    }
+    else
+    {
+        int evicted = mLru.back();
+        mLru.pop_back();
+        slot = mSegmentSlots[evicted];
+        mSegmentSlots.erase(evicted);
+    }
+
+    mSlots[slot].segment = segment;
+    mSlots[slot].valid.assign(sFrameCacheSegmentFrames, false);
+    mSegmentSlots[segment] = slot;
+    mLru.push_front(segment);
+    return slot;
+}
+
+void FrameCache::touchLocked(int segment)
+{
+    // Segments are few, a linear search is cheap next to copying a frame
+    auto it = std::find(mLru.begin(), mLru.end(), segment);
+    if (it != mLru.end())
+    {
+        mLru.splice(mLru.begin(), mLru, it);
+    }
+}
+
+uint8_t *FrameCache::framePtr(int slot, int offset) const
+{
+    return mData + (size_t(slot) * sFrameCacheSegmentFrames + offset) * mFrameStride;
+}
@@ -0,0 +1,78 @@
+#ifndef FRAME_CACHE
+#define FRAME_CACHE
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+// Frames per cache segment, the unit of allocation and eviction
+constexpr int sFrameCacheSegmentFrames{32};
+
+// Disk-backed cache of decoded frames for random access without the decoder
+// Frames are copied straight into a memory-mapped file, which the kernel writes
+// back in the background. The file is split into fixed-size slots that each hold
+// one segment of consecutive frames, the least recently used segment is evicted
+// when the budget is full.
+class FrameCache
+{
+private:
+    // One slot of the file holding a segment
+    struct Slot
+    {
+        int segment{-1};
+        std::vector<bool> valid;
+    };
+
+    mutable std::mutex mMutex;
+    uint8_t *mData{nullptr};
+    size_t mSize{0};
+    cv::Size mFrameSize;
+    size_t mFrameStride{0};
+
+    // Segment index to slot, and segments from most to least recently used
+    std::vector<Slot> mSlots;
+    std::unordered_map<int, int> mSegmentSlots;
+    std::list<int> mLru;
+
+    // Get the slot of a segment, evicting the least recently used one if needed
+    // The mutex must be held
+    int slotAcquireLocked(int segment);
+    // Move a segment to the front of the LRU list, the mutex must be held
+    void touchLocked(int segment);
+    // Get the address of a frame in a slot
+    uint8_t *framePtr(int slot, int offset) const;
+
+public:
+    FrameCache() = default;
+    ~FrameCache() { close(); }
+
+    // Delete copy and move constructors and assignment operators
+    FrameCache(const FrameCache &) = delete;
+    FrameCache &operator=(const FrameCache &) = delete;
+    FrameCache(FrameCache &&) = delete;
+    FrameCache &operator=(FrameCache &&) = delete;
+
+    // Create an unlinked cache file in the directory for BGR frames of the given size
+    // The file is no larger than budgetBytes but holds at least one segment
+    // Returns true if successful, false otherwise
+    bool open(const std::string &directory, cv::Size frameSize, size_t budgetBytes);
+    // Drop the cache
+    void close();
+    // Check if the cache is open
+    bool isOpened() const;
+    // Copy a decoded frame into its slot, frames of another size are skipped
+    // Only one thread stores, and never while the cache is opened or closed
+    void store(int index, const cv::Mat &image);
+    // Check if a frame is cached
+    bool contains(int index) const;
+    // Copy a cached frame into the image
+    // Returns false if the frame is not cached
+    bool load(int index, cv::Mat &image);
+};
+
+#endif
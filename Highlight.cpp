@@ -0,0 +1,42 @@
+#include "Highlight.h"
+
+#include "opencv2/imgproc.hpp"
+
+// Blend the box with green in place: 70% of the pixel plus 30% of pure green
+static void highlightBox(cv::Mat &image, const cv::Rect &box)
+{
+    cv::Mat roi = image(box);
+    if (roi.type() != CV_8UC3)
+    {
+        roi.convertTo(roi, roi.type(), 0.7);  // scale existing pixels
+        roi += cv::Scalar(0, 255 * 0.3, 0.0); // add green contribution
+        return;
+    }
+
+    // One pass over the rows, without the temporaries of convertTo and the addition
+    for (int y = 0; y < roi.rows; ++y)
+    {
+        uchar *pixel = roi.ptr<uchar>(y);
+        for (int x = 0; x < roi.cols * 3; x += 3)
+        {
+            pixel[x] = cv::saturate_cast<uchar>(pixel[x] * 0.7);
+            pixel[x + 1] = cv::saturate_cast<uchar>(pixel[x + 1] * 0.7 + 255 * 0.3);
+            pixel[x + 2] = cv::saturate_cast<uchar>(pixel[x + 2] * 0.7);
+        }
+    }
+}
+
+void frameHighlight(Frame &frame)
+{
+    cv::Rect bounds(0, 0, frame.image.cols, frame.image.rows);
+    for (const auto &result : frame.results)
+    {
+        cv::Rect box = result.box & bounds;
+        if (!result.active || box.empty())
+        {
+            continue;
+        }
+        frameImageWritable(frame);
+        highlightBox(frame.image, box);
+    }
+}
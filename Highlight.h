@@ -0,0 +1,10 @@
+#ifndef HIGHLIGHT
+#define HIGHLIGHT
+
+#include "DataStructs.h"
+
+// Draw the active tracker boxes of the frame into its BGR image
+// Frames wrapping a read-only mapping get their own copy of the image first
+void frameHighlight(Frame &frame);
+
+#endif
@@ -0,0 +1,106 @@
+#include "KeyframeIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "opencv2/videoio.hpp"
+
+void KeyframeIndex::buildIndex(std::stop_token st, std::string filename)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // Open the file in raw mode: grab() only demuxes packets, nothing is decoded
+    cv::VideoCapture cap(filename, cv::CAP_FFMPEG, {cv::CAP_PROP_FORMAT, -1});
+    if (!cap.isOpened())
+    {
+        return;
+    }
+
+    // Packets arrive in decode order, which differs from presentation order once
+    // frames are reordered (B-frames). Keyframes are placed by their presentation
+    // timestamp instead, the packet count is only used for streams without timestamps.
+    double fps = cap.get(cv::CAP_PROP_FPS);
+    bool timestamps = fps > 0.0;
+    std::vector<int> keyframes;
+    std::vector<int> keyPackets;
+    int index = 0;
+    while (!st.stop_requested() && cap.grab())
+    {
+        if (cap.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0.0)
+        {
+            double ms = cap.get(cv::CAP_PROP_POS_MSEC);
+            timestamps = timestamps && (ms > 0.0 || index == 0);
+            keyframes.push_back(static_cast<int>(std::lround(ms * fps / 1000.0)));
+            keyPackets.push_back(index);
+        }
+        index += 1;
+    }
+
+    if (timestamps)
+    {
+        std::sort(keyframes.begin(), keyframes.end());
+        keyframes.erase(std::unique(keyframes.begin(), keyframes.end()), keyframes.end());
+    }
+    else
+    {
+        keyframes = std::move(keyPackets);
+    }
+
+    // Without keyframe flags the index would be useless
+    if (st.stop_requested() || keyframes.empty())
+    {
+        return;
+    }
+
+    {
+        std::scoped_lock lock(mMutex);
+        mKeyframes = std::move(keyframes);
+    }
+    mReady.store(true);
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Keyframe index: " << mKeyframes.size() << " keyframes in " << index << " frames, built in "
+              << elapsed.count() << " ms" << std::endl;
+}
+
+void KeyframeIndex::build(const std::string &filename)
+{
+    clear();
+    mBuilder = std::jthread([this, filename](std::stop_token st)
+                            { buildIndex(st, filename); });
+}
+
+void KeyframeIndex::clear()
+{
+    // Stop and join a running builder before resetting the index
+    mBuilder = std::jthread();
+    mReady.store(false);
+
+    std::scoped_lock lock(mMutex);
+    mKeyframes.clear();
+}
+
+bool KeyframeIndex::ready() const
+{
+    return mReady.load();
+}
+
+int KeyframeIndex::keyframeAtOrBefore(int index) const
+{
+    if (!mReady.load())
+    {
+        return -1;
+    }
+
+    std::scoped_lock lock(mMutex);
+
+    // First keyframe after index, the one before it is the answer
+    auto it = std::upper_bound(mKeyframes.begin(), mKeyframes.end(), index);
+    if (it == mKeyframes.begin())
+    {
+        return -1;
+    }
+    return *(it - 1);
+}
@@ -0,0 +1,44 @@
+#ifndef KEYFRAME_INDEX
+#define KEYFRAME_INDEX
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Frame indices of the keyframes of a video file, in presentation order,
+// built in the background by demuxing the file without decoding it
+class KeyframeIndex
+{
+private:
+    mutable std::mutex mMutex;
+    std::vector<int> mKeyframes;
+    std::atomic<bool> mReady{false};
+    std::jthread mBuilder;
+
+    // Demux the whole file and collect the keyframe indices
+    void buildIndex(std::stop_token st, std::string filename);
+
+public:
+    KeyframeIndex() = default;
+    ~KeyframeIndex() = default;
+
+    // Delete copy and move constructors and assignment operators
+    KeyframeIndex(const KeyframeIndex &) = delete;
+    KeyframeIndex &operator=(const KeyframeIndex &) = delete;
+    KeyframeIndex(KeyframeIndex &&) = delete;
+    KeyframeIndex &operator=(KeyframeIndex &&) = delete;
+
+    // Start building the index for the given file, replacing the current one
+    void build(const std::string &filename);
+    // Stop building and forget the index
+    void clear();
+    // Check if the index has been built
+    bool ready() const;
+    // Get the last keyframe at or before the given frame index
+    // Returns -1 if the index is not ready
+    int keyframeAtOrBefore(int index) const;
+};
+
+#endif
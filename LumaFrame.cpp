@@ -0,0 +1,88 @@
+#include "LumaFrame.h"
+
+#include "opencv2/imgproc.hpp"
+
+bool nativeFormatOf(const cv::Mat &native, cv::Size frameSize, NativeFormat &format)
+{
+    if (native.channels() == 3)
+    {
+        format = NativeFormat::Bgr;
+    }
+    else if (native.channels() == 2 && native.cols == frameSize.width && native.rows == frameSize.height)
+    {
+        format = NativeFormat::Yuyv;
+    }
+    else if (native.channels() == 1 && native.cols == frameSize.width && native.rows == frameSize.height)
+    {
+        format = NativeFormat::Gray;
+    }
+    else if (native.channels() == 1 && native.cols == frameSize.width && native.rows == frameSize.height * 3 / 2)
+    {
+        format = NativeFormat::I420;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool frameSetNative(Frame &frame, cv::Mat &&native, cv::Size frameSize)
+{
+    NativeFormat format = NativeFormat::Bgr;
+    if (native.empty() || native.depth() != CV_8U || !nativeFormatOf(native, frameSize, format))
+    {
+        return false;
+    }
+
+    frame.nativeFormat = format;
+    frame.image = cv::Mat();
+    frame.native = cv::Mat();
+    switch (format)
+    {
+    case NativeFormat::Bgr:
+        // Nothing left to render, the trackers still get a single plane
+        frame.image = std::move(native);
+        cv::cvtColor(frame.image, frame.luma, cv::COLOR_BGR2GRAY);
+        break;
+    case NativeFormat::Gray:
+        frame.native = std::move(native);
+        frame.luma = frame.native;
+        break;
+    case NativeFormat::I420:
+        // The Y plane is the top of the buffer, viewed without a copy
+        frame.native = std::move(native);
+        frame.luma = frame.native.rowRange(0, frameSize.height);
+        break;
+    case NativeFormat::Yuyv:
+        // Luma is interleaved with chroma, pulling it out is still far cheaper than BGR
+        frame.native = std::move(native);
+        cv::extractChannel(frame.native, frame.luma, 0);
+        break;
+    }
+    return true;
+}
+
+void frameRender(Frame &frame)
+{
+    if (!frame.image.empty() || frame.native.empty())
+    {
+        return;
+    }
+
+    switch (frame.nativeFormat)
+    {
+    case NativeFormat::Bgr:
+        frame.image = frame.native;
+        break;
+    case NativeFormat::Gray:
+        cv::cvtColor(frame.native, frame.image, cv::COLOR_GRAY2BGR);
+        break;
+    case NativeFormat::I420:
+        cv::cvtColor(frame.native, frame.image, cv::COLOR_YUV2BGR_I420);
+        break;
+    case NativeFormat::Yuyv:
+        cv::cvtColor(frame.native, frame.image, cv::COLOR_YUV2BGR_YUYV);
+        break;
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef LUMA_FRAME
+#define LUMA_FRAME
+
+#include "DataStructs.h"
+
+#include "opencv2/core.hpp"
+
+// Recognize the layout of a native decoder frame of the given video size
+// Returns true if successful, false for layouts that cannot be tracked on
+bool nativeFormatOf(const cv::Mat &native, cv::Size frameSize, NativeFormat &format);
+
+// Store a native decoder frame in the frame and point its luma at the Y plane
+// BGR decoder output goes straight to the image, with a gray copy for the trackers
+// Returns true if successful, false if the layout is not recognized
+bool frameSetNative(Frame &frame, cv::Mat &&native, cv::Size frameSize);
+
+// Convert the native frame to the BGR image if it has not been converted yet
+void frameRender(Frame &frame);
+
+#endif
@@ -5,12 +5,16 @@
 
 #include <concepts>
 #include <optional>
+#include <stop_token>
+#include <utility>
 
+// A pipeline stage: frames are taken, updated in place and then moved on,
+// so each frame has exactly one owner at any time
 template <typename T>
-concept Node = requires(T t, Frame &f, const Frame &cf, std::stop_token st) {
+concept Node = requires(T t, Frame &f, std::stop_token st) {
     { t.getFrame(st) } -> std::same_as<std::optional<Frame>>;
     t.updateFrame(f);
-    t.passFrame(cf, st);
+    t.passFrame(std::move(f), st);
 };
 
 #endif
\ No newline at end of file
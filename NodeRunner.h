@@ -1,13 +1,17 @@
 #ifndef NODE_RUNNER_H
 #define NODE_RUNNER_H
 
+#include "Affinity.h"
+#include "AllocTracker.h"
 #include "ControlNode.h"
 #include "DataStructs.h"
 #include "Node.h"
 #include "ThreadSafeQueue.h"
 
+#include <iostream>
 #include <thread>
 #include <stop_token>
+#include <vector>
 
 template <Node NodeType>
 class NodeRunner
@@ -15,10 +19,13 @@ class NodeRunner
 private:
     NodeType mNodeLogic;
     std::shared_ptr<ControlNode> mControlNode;
+    // Stage the thread's allocations are charged to
+    AllocStage mStage;
     std::jthread mWorker;
 
     void run()
     {
+        allocStageSet(mStage);
         std::stop_token st = mControlNode->stopSourceGet().get_token();
         while (!st.stop_requested())
         {
@@ -30,26 +37,36 @@ private:
                 continue;
             }
 
-            Frame frame = std::move(*frameOpt);
-
-            if (frame.generation != mControlNode->generationGet())
+            if (frameOpt->generation != mControlNode->generationGet())
             {
                 continue;
             }
 
             // Process the frame using the node logic
-            mNodeLogic.updateFrame(frame);
+            mNodeLogic.updateFrame(*frameOpt);
+
+#ifdef ENABLE_FRAME_CHECKS
+            // Passing a frame on hands over its buffers, so this stage
+            // must not keep any other reference to them
+            if (!frameOwnsBuffers(*frameOpt))
+            {
+                std::cerr << "Warning: Frame " << frameOpt->idx << " passed on while its buffers are still shared." << std::endl;
+            }
+#endif
 
-            // Do something with the updated frame
-            mNodeLogic.passFrame(frame, st);
+            // Move the updated frame on to the next stage
+            mNodeLogic.passFrame(std::move(*frameOpt), st);
+            allocFrameDone(mStage);
         }
     }
 
 public:
     NodeRunner(NodeType &&nodeLogic,
-               std::shared_ptr<ControlNode> controlNode)
+               std::shared_ptr<ControlNode> controlNode,
+               AllocStage stage = AllocStage::Other)
         : mNodeLogic(std::move(nodeLogic)),
-          mControlNode(controlNode)
+          mControlNode(controlNode),
+          mStage(stage)
     {
     }
     ~NodeRunner() = default;
@@ -59,10 +76,15 @@ public:
     NodeRunner(NodeRunner &&) = delete;
     NodeRunner operator=(NodeRunner &&) = delete;
 
-    void start()
+    // Start the stage, pinned to the cores unless the list is empty
+    void start(const std::vector<int> &cpus = {})
     {
         mWorker = std::jthread([this](std::stop_token st)
                                { run(); });
+        if (!threadPin(mWorker.native_handle(), cpus))
+        {
+            std::cerr << "Warning: Could not pin a stage to cores " << cpuListFormat(cpus) << std::endl;
+        }
     }
 };
 
@@ -1,3 +1,4 @@
+#include "AllocTracker.h"
 #include "DataStructs.h"
 #include "NodeRunner.h"
 #include "ObjectHighlighter.h"
@@ -5,7 +6,10 @@
 #include "TrackerNode.h"
 #include "OutputNode.h"
 
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <filesystem>
 #include <iostream>
 #include <mutex>
 #include <string>
@@ -20,6 +24,130 @@ void ObjectHighlighter::writerSettings(const std::string &outputPath, const std:
     mFormat = format;
 }
 
+// Set the memory budget for decoded frames in flight (0 for unlimited)
+void ObjectHighlighter::memoryBudget(size_t megabytes)
+{
+    mFrameBudgetBytes = megabytes == 0 ? SIZE_MAX : megabytes * 1024 * 1024;
+}
+
+// Publish rendered frames to the named POSIX shared memory (empty to disable)
+void ObjectHighlighter::sharedMemoryOutput(const std::string &name)
+{
+    mShmName = name;
+}
+
+// Set the scale of the displayed preview, trackers and writers keep full resolution
+void ObjectHighlighter::previewScale(double scale)
+{
+    mControlNode->previewScaleSet(scale);
+}
+
+// Choose what a save writes, and where and how large object crops are
+void ObjectHighlighter::exportSettings(ExportMode mode, const std::string &cropDirectory, int cropSize)
+{
+    mExportMode = mode;
+    mCropDirectory = cropDirectory;
+    mCropSize = cropSize;
+}
+
+// Stream the tracker boxes of every frame to a file (empty to disable)
+// Files ending in .jsonl are JSON Lines, others use the binary format of ResultsFormat.h
+void ObjectHighlighter::resultsOutput(const std::string &path)
+{
+    mResultsPath = path;
+}
+
+// Treat the source as live even if it is not a device or a pipe
+void ObjectHighlighter::liveInput(bool live)
+{
+    if (live)
+    {
+        mControlNode->capLiveSet(true);
+    }
+}
+
+// Cache decoded frames on disk for seeks without the decoder (0 MB to disable)
+void ObjectHighlighter::frameCache(const std::string &directory, size_t megabytes)
+{
+    mControlNode->frameCacheConfigure(directory, megabytes * 1024 * 1024);
+}
+
+// Limit the tracking time per frame (0 for unlimited), late updates are deferred fairly
+void ObjectHighlighter::trackingBudget(double milliseconds)
+{
+    mControlNode->trackingBudgetSet(milliseconds);
+}
+
+// Choose what new trackers search in: the whole frame, or a window viewed or copied out of it
+void ObjectHighlighter::searchWindow(SearchWindowMode mode)
+{
+    mControlNode->searchWindowModeSet(mode);
+}
+
+// Divide the cores (0 for all) between the stages, the tracker pool and OpenCV
+// opencvThreads fixes OpenCV's share, -1 chooses it automatically
+// poolCores caps the pool at the cores it is pinned to, 0 if it floats
+void ObjectHighlighter::threadBudget(int threads, int opencvThreads, int poolCores)
+{
+    mControlNode->threadBudgetSet(threadBudgetSplit(threads, opencvThreads, poolCores));
+}
+
+// Pin the stages and the pool to cores, e.g. to keep frame handoffs on one socket
+void ObjectHighlighter::affinity(const AffinityLayout &layout)
+{
+    mControlNode->affinitySet(layout);
+}
+
+// Choose where and how snapshots are written, and the frames a burst saves
+// A burst without a first frame only sets the step of bursts started with 'b'
+void ObjectHighlighter::snapshotSettings(const SnapshotSettings &settings, const BurstRange &burst)
+{
+    mSnapshotSettings = settings;
+    mBurst = burst;
+}
+
+// Drive playback from scripted actions instead of the keyboard, timing each action
+void ObjectHighlighter::scenario(const ScenarioSettings &scenario)
+{
+    mScenario = scenario;
+}
+
+// Track decoded videos on the luma plane of the decoder's native frames
+void ObjectHighlighter::lumaTracking(bool luma)
+{
+    if (luma)
+    {
+        mControlNode->capLumaSet(true);
+    }
+}
+
+// Run without windows or keyboard input, playing the video through once
+void ObjectHighlighter::headless(bool headless)
+{
+    mHeadless = headless;
+}
+
+// Create the main window unless the run is headless
+void ObjectHighlighter::windowCreate()
+{
+    if (!mHeadless)
+    {
+        VideoProcessor::windowCreate();
+    }
+}
+
+// Hold a capture-to-tracked latency target by lowering quality within the given bounds
+// A target of 0 disables the controller
+void ObjectHighlighter::qualityOfService(double latencyTargetMs, int maxUpdateStride, double minPreviewScale,
+                                         int maxPatchArea, int minPatchArea)
+{
+    mQosSettings.latencyTargetMs = latencyTargetMs;
+    mQosSettings.maxUpdateStride = maxUpdateStride;
+    mQosSettings.minPreviewScale = minPreviewScale;
+    mQosSettings.maxPatchArea = maxPatchArea;
+    mQosSettings.minPatchArea = minPatchArea;
+}
+
 // Play the video with object highlighting and saving capabilities
 void ObjectHighlighter::playVideo()
 {
@@ -30,19 +158,67 @@ void ObjectHighlighter::playVideo()
         return;
     }
 
-    auto readerTrackerQueue = std::make_shared<ThreadSafeQueue<Frame>>(sProcessorQueueSize);
-    auto trackerWriterQueue = std::make_shared<ThreadSafeQueue<Frame>>(sWriterQueueSize);
+    // The user's preview scale is the highest quality the controller returns to
+    mQosSettings.maxPreviewScale = mControlNode->previewScaleGet();
+    mControlNode->qosConfigure(mQosSettings);
 
-    auto readerNode = NodeRunner<ReaderNode>(ReaderNode(mControlNode, readerTrackerQueue),
-                                             mControlNode);
-    auto trackerNode = NodeRunner<TrackerNode>(TrackerNode(mControlNode, readerTrackerQueue, trackerWriterQueue),
-                                               mControlNode);
-    auto outputNode = NodeRunner<OutputNode>(OutputNode(sMainTitle, mOutputPath, mFormat, mControlNode, trackerWriterQueue),
-                                             mControlNode);
+    // Headless runs only need BGR frames for the shared memory output and saves
+    // Snapshots and bursts render the frames they capture themselves
+    mControlNode->renderSet(!mHeadless || !mShmName.empty());
 
-    readerNode.start();
-    trackerNode.start();
-    outputNode.start();
+    // Live sources only keep the newest frame waiting at each stage
+    bool live = mControlNode->capIsLive();
+    auto readerTrackerQueue = std::make_shared<ThreadSafeQueue<Frame>>(live ? sLiveQueueSize : sProcessorQueueSize);
+    auto trackerWriterQueue = std::make_shared<ThreadSafeQueue<Frame>>(live ? sLiveQueueSize : sWriterQueueSize);
+    auto frameBudget = std::make_shared<FrameBudget>(mFrameBudgetBytes);
+    mControlNode->frameSpareLimitSet(mFrameBudgetBytes / sSpareBudgetDivisor);
+
+    auto readerNode = NodeRunner<ReaderNode>(ReaderNode(mControlNode, readerTrackerQueue, frameBudget),
+                                             mControlNode, AllocStage::Reader);
+    // Object crops use the codec and container of the full output
+    std::shared_ptr<CropExporter> cropExporter;
+    if (mExportMode != ExportMode::Full)
+    {
+        std::string extension = std::filesystem::path(mOutputPath).extension().string();
+        if (extension.empty() || isRawVideoPath(mOutputPath))
+        {
+            extension = ".mp4";
+        }
+        int fourcc = mFormat.length() == 4 ? cv::VideoWriter::fourcc(mFormat[0], mFormat[1], mFormat[2], mFormat[3])
+                                           : cv::VideoWriter::fourcc('m', 'p', '4', 'v');
+        cropExporter = std::make_shared<CropExporter>(mCropDirectory, extension, fourcc,
+                                                      mControlNode->capGet(cv::CAP_PROP_FPS), mCropSize);
+    }
+
+    // Tracker results file, outlives the nodes so every recorded frame is written
+    std::shared_ptr<ResultsWriter> resultsWriter;
+    if (!mResultsPath.empty())
+    {
+        resultsWriter = std::make_shared<ResultsWriter>();
+        if (!resultsWriter->open(mResultsPath))
+        {
+            std::cerr << "Error: Could not open results file: " << mResultsPath << std::endl;
+            resultsWriter.reset();
+        }
+    }
+
+    auto trackerNode = NodeRunner<TrackerNode>(TrackerNode(mControlNode, readerTrackerQueue, trackerWriterQueue, cropExporter, resultsWriter),
+                                               mControlNode, AllocStage::Tracker);
+    // Snapshots are encoded with the codec share of the cores
+    auto snapshotWriter = std::make_shared<SnapshotWriter>(mSnapshotSettings, mControlNode->threadBudgetGet().codec);
+
+    auto outputNode = NodeRunner<OutputNode>(OutputNode(sMainTitle, mOutputPath, mFormat, mShmName, mExportMode, mHeadless,
+                                                        snapshotWriter, mBurst, mScenario, mControlNode, trackerWriterQueue),
+                                             mControlNode, AllocStage::Output);
+
+    // Allocations are counted from here, the steady state starts after each stage's warm-up
+    allocTrackingStart();
+    auto start = std::chrono::steady_clock::now();
+
+    AffinityLayout layout = mControlNode->affinityGet();
+    readerNode.start(layout.reader);
+    trackerNode.start(layout.tracker);
+    outputNode.start(layout.output);
 
     // Wait for processing to complete (e.g., when stop is requested)
     std::mutex mtx;
@@ -62,7 +238,19 @@ void ObjectHighlighter::playVideo()
         cv.wait(lock, [&done]
                 { return done; });
     }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
 
     // Ensure all OpenCV windows are closed
     cv::destroyAllWindows();
+
+    // Report how much memory the frames in flight needed at most
+    cout << "Peak in-flight frame memory: " << frameBudget->peakGet() / (1024.0 * 1024.0) << " MB";
+    if (frameBudget->capacityGet() != SIZE_MAX)
+    {
+        cout << " (budget " << frameBudget->capacityGet() / (1024 * 1024) << " MB)";
+    }
+    cout << endl;
+
+    // Builds with ENABLE_ALLOC_TRACKING report the heap allocations of each stage per frame
+    allocTrackingReport(cout, elapsed.count());
 }
@@ -1,7 +1,11 @@
 #ifndef OBJECT_HIGHLIGHTER
 #define OBJECT_HIGHLIGHTER
 
+#include "CropExporter.h"
 #include "DataStructs.h"
+#include "FrameBudget.h"
+#include "Scenario.h"
+#include "SnapshotWriter.h"
 #include "ThreadSafeQueue.h"
 #include "VideoProcessor.h"
 
@@ -16,6 +20,10 @@
 // Window title for saving frames
 constexpr int sProcessorQueueSize{8};
 constexpr int sWriterQueueSize{8};
+// Live sources keep a single pending frame per stage
+constexpr int sLiveQueueSize{1};
+// Default memory budget for decoded frames in flight across all queues
+constexpr size_t sFrameBudgetMB{512};
 
 class ObjectHighlighter : public VideoProcessor
 {
@@ -30,10 +38,42 @@ public:
 
     void playVideo() override;
     void writerSettings(const std::string &outputPath, const std::string &format);
+    void memoryBudget(size_t megabytes);
+    void sharedMemoryOutput(const std::string &name);
+    void previewScale(double scale);
+    void exportSettings(ExportMode mode, const std::string &cropDirectory, int cropSize);
+    void resultsOutput(const std::string &path);
+    void liveInput(bool live);
+    void frameCache(const std::string &directory, size_t megabytes);
+    void trackingBudget(double milliseconds);
+    void searchWindow(SearchWindowMode mode);
+    void threadBudget(int threads, int opencvThreads, int poolCores = 0);
+    void affinity(const AffinityLayout &layout);
+    void snapshotSettings(const SnapshotSettings &settings, const BurstRange &burst);
+    void scenario(const ScenarioSettings &scenario);
+    void lumaTracking(bool luma);
+    void headless(bool headless);
+    void qualityOfService(double latencyTargetMs, int maxUpdateStride, double minPreviewScale,
+                          int maxPatchArea, int minPatchArea);
+
+protected:
+    // Headless runs have no window to create
+    void windowCreate() override;
 
 private:
     std::string mOutputPath;
     std::string mFormat;
+    std::string mShmName;
+    std::string mResultsPath;
+    ExportMode mExportMode{ExportMode::Full};
+    bool mHeadless{false};
+    SnapshotSettings mSnapshotSettings;
+    BurstRange mBurst;
+    ScenarioSettings mScenario;
+    std::string mCropDirectory;
+    int mCropSize{128};
+    QosSettings mQosSettings;
+    size_t mFrameBudgetBytes{sFrameBudgetMB * 1024 * 1024};
     cv::VideoWriter mVideoWriter;
 };
 
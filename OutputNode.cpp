@@ -1,9 +1,13 @@
 #include "OutputNode.h"
+#include "Highlight.h"
+#include "LumaFrame.h"
 
 #include <algorithm>
+#include <climits>
 #include <iostream>
 
 #include "opencv2/highgui.hpp"
+#include "opencv2/imgproc.hpp"
 
 std::optional<Frame> OutputNode::getFrame(std::stop_token st)
 {
@@ -12,54 +16,64 @@ std::optional<Frame> OutputNode::getFrame(std::stop_token st)
 
 void OutputNode::updateFrame(Frame &frame)
 {
-#ifdef ENABLE_PROFILING
-    static bool doOnce = true;
-    if (doOnce)
-    {
-        doOnce = false;
-
-        cv::Rect rect = cv::Rect(281, 426, 192, 262);
-
-        std::vector<ObjectTracker> trackers;
-        ObjectTracker ot;
-
-        // Create a KCF tracker
-        cv::Ptr<cv::Tracker> tracker = cv::TrackerKCF::create();
-
-        // Initialize the tracker with the current frame and bounding box
-        tracker->init(frame.image, rect);
+}
 
-        // Store the tracker and bounding box
-        ot.box = rect;
-        ot.tracker = tracker;
-        trackers.push_back(ot);
+void OutputNode::passFrame(Frame &&frame, std::stop_token st)
+{
+    outputFrame(frame);
 
-        // Push the new trackers to the control node and rewind to the current frame
-        mControlNode->trackersPushBackAndRewind(std::move(trackers), frame.idx);
-    }
-#endif
+    // The reader decodes into the buffers of frames that were output
+    mControlNode->frameRecycle(std::move(frame));
 }
 
-void OutputNode::passFrame(const Frame &frame, std::stop_token st)
+// Save, publish or show the frame and handle the input for it
+void OutputNode::outputFrame(Frame &frame)
 {
+    // The first frame after a scripted action shows when the pipeline resumed
+    scenarioResume();
+
     // If control is in save mode, just save the frame and move on
     if (mControlNode->isSaving())
     {
         // Check for end of saving signal
         if (frame.idx == -1)
         {
-            // Finished saving, return to main drawing
+            // Finished saving, close the output file and return to main drawing
+            mVideoWriter.release();
+            mRawWriter.release();
             mControlNode->setIsSaving(0);
-            cv::destroyWindow(mSaveWindowName);
+            if (!mHeadless)
+            {
+                cv::destroyWindow(mSaveWindowName);
+            }
             return;
         }
 
+        // Hand the frame to the shared-memory consumer
+        publishFrame(frame);
+
         // Show the saving window
-        cv::imshow(mSaveWindowName, frame.image);
-        cv::waitKey(1);
+        if (!mHeadless)
+        {
+            cv::imshow(mSaveWindowName, frame.preview.empty() ? frame.image : frame.preview);
+            cv::waitKey(1);
+        }
 
         // Write the frame to the video writer
-        mVideoWriter.write(frame.image);
+        // In crops only exports the tracker stage writes one video per object instead
+        if (mExportMode == ExportMode::Crops)
+        {
+            return;
+        }
+
+        if (mRawWriter.isOpened())
+        {
+            mRawWriter.write(frame.image);
+        }
+        else
+        {
+            mVideoWriter.write(frame.image);
+        }
         return;
     }
 
@@ -67,29 +81,65 @@ void OutputNode::passFrame(const Frame &frame, std::stop_token st)
     if (frame.idx == -1)
     {
         // We have displayed all the frames, end program
+        scenarioFinish();
         mControlNode->stopSourceGet().request_stop();
 
-#ifndef ENABLE_PROFILING
-        cv::waitKey(0);
-#endif
+        if (!mHeadless)
+        {
+            cv::waitKey(0);
+        }
 
         // Release the video capture
         mControlNode->capRelease();
         return;
     }
 
-#ifdef ENABLE_PROFILING
-    return;
-#endif
+    // Hand the frame to the shared-memory consumer
+    publishFrame(frame);
+
+    // Run the scripted actions that are due
+    if (!runScenario(frame))
+    {
+        // The scenario ended playback
+        scenarioFinish();
+        mControlNode->stopSourceGet().request_stop();
+        mControlNode->capRelease();
+        return;
+    }
+
+    // Nothing is shown without a display, only bursts are saved
+    if (mHeadless)
+    {
+        if (burstWanted(frame.idx))
+        {
+            captureFrameWithHighlights(frame);
+        }
+        mControlNode->firstFrameShown();
+        return;
+    }
+
+    // Show how old live frames are when they reach the screen
+    if (mControlNode->capIsLive())
+    {
+        reportFrameAge(frame);
+    }
+
+    // Save the frames of a running burst as they are shown
+    if (burstWanted(frame.idx))
+    {
+        captureFrameWithHighlights(frame);
+    }
 
     // Displays the video to the user
-    cv::imshow(mWindowName, frame.image);
+    cv::imshow(mWindowName, frame.preview.empty() ? frame.image : frame.preview);
 
-    // Allow user to interact with currently shown frame
+    // Allow user to interact with currently shown frame, this also paints it
     int key = cv::waitKey(1);
+    mControlNode->firstFrameShown();
     if (!handlePlaybackInput(key, frame))
     {
         // User requested to quit
+        scenarioFinish();
         mControlNode->stopSourceGet().request_stop();
 
         // Release the video capture
@@ -98,7 +148,7 @@ void OutputNode::passFrame(const Frame &frame, std::stop_token st)
 }
 
 // Handle user input during playback
-bool OutputNode::handlePlaybackInput(int key, const Frame &frame)
+bool OutputNode::handlePlaybackInput(int key, Frame &frame)
 {
     if (key == 'p')
     {
@@ -108,6 +158,10 @@ bool OutputNode::handlePlaybackInput(int key, const Frame &frame)
     {
         return false;
     }
+    else if ((key == 'r' || key == 'z' || key == 's') && mControlNode->capIsLive())
+    {
+        std::cout << "Rewinding and saving are not available for live input." << std::endl;
+    }
     else if (key == 'r')
     {
         rewindVideo(-1);
@@ -118,7 +172,7 @@ bool OutputNode::handlePlaybackInput(int key, const Frame &frame)
     }
     else if (key == 's')
     {
-        if (!loadWriter(mOutputPath, mFormat))
+        if (mExportMode != ExportMode::Crops && !loadWriter(mOutputPath, mFormat))
         {
             std::cerr << "Error: Could not open video writer: " << mOutputPath;
             std::cerr << " with format: " << mFormat << std::endl;
@@ -132,8 +186,15 @@ bool OutputNode::handlePlaybackInput(int key, const Frame &frame)
     else if (key == 'o')
     {
         // Capture the current frame with highlights
-        std::string filename = "frame_" + std::to_string(frame.idx) + ".jpg";
-        captureFrameWithHighlights(filename, frame.image);
+        captureFrameWithHighlights(frame);
+    }
+    else if (key == 'b')
+    {
+        // Start saving every few frames from here on, or stop the burst
+        // A burst given up front keeps running either way
+        bool start = mKeyBurst.first < 0;
+        mKeyBurst = start ? BurstRange{frame.idx, INT_MAX, mBurstStep} : BurstRange{};
+        std::cout << "Burst " << (start ? "started" : "stopped") << " at frame " << frame.idx << std::endl;
     }
 
     return true;
@@ -148,9 +209,10 @@ void OutputNode::selectObjects(const Frame &frame)
         return;
     }
 
-    // Let the user select multiple ROIs
+    // Let the user select multiple ROIs on the displayed image
+    const cv::Mat &shown = frame.preview.empty() ? frame.image : frame.preview;
     std::vector<cv::Rect> boundingBoxes;
-    cv::selectROIs(mWindowName, frame.image, boundingBoxes);
+    cv::selectROIs(mWindowName, shown, boundingBoxes);
 
     // If no boxes were selected, return
     if (boundingBoxes.empty())
@@ -158,27 +220,29 @@ void OutputNode::selectObjects(const Frame &frame)
         return;
     }
 
-    // Create a tracker for each selected bounding box
-    std::vector<ObjectTracker> trackers;
-    trackers.reserve(boundingBoxes.size());
-    for (const auto &bbox : boundingBoxes)
+    // Map boxes selected on the preview back to full resolution
+    if (!frame.preview.empty())
     {
-        ObjectTracker ot;
-
-        // Create a KCF tracker
-        cv::Ptr<cv::Tracker> tracker = cv::TrackerKCF::create();
-
-        // Initialize the tracker with the current frame and bounding box
-        tracker->init(frame.image, bbox);
+        double sx = static_cast<double>(frame.image.cols) / frame.preview.cols;
+        double sy = static_cast<double>(frame.image.rows) / frame.preview.rows;
+        cv::Rect bounds(0, 0, frame.image.cols, frame.image.rows);
+        for (auto &bbox : boundingBoxes)
+        {
+            int x0 = cvRound(bbox.x * sx);
+            int y0 = cvRound(bbox.y * sy);
+            int x1 = cvRound((bbox.x + bbox.width) * sx);
+            int y1 = cvRound((bbox.y + bbox.height) * sy);
+            bbox = cv::Rect(x0, y0, x1 - x0, y1 - y0) & bounds;
+        }
 
-        // Store the tracker and bounding box
-        ot.box = bbox;
-        ot.tracker = tracker;
-        trackers.push_back(std::move(ot));
+        // Drop boxes that vanished when mapped to the frame
+        std::erase_if(boundingBoxes, [](const cv::Rect &bbox)
+                      { return bbox.empty(); });
     }
 
-    // Push the new trackers to the control node and rewind to the current frame
-    mControlNode->trackersPushBackAndRewind(std::move(trackers), frame.idx);
+    // Create a tracker for each selected bounding box in parallel,
+    // then push them to the control node and rewind to the current frame
+    mControlNode->trackersCreateAndRewind(frameTrackingImage(frame), boundingBoxes, frame.idx);
 }
 
 // Rewind the video by the given number of frames
@@ -206,6 +270,14 @@ void OutputNode::rewindVideo(int frameCount)
 // Load the video writer with the given output path and fourcc format
 bool OutputNode::loadWriter(const std::string &outputPath, const std::string &fourcc)
 {
+    // Raw video files are written without encoding
+    if (isRawVideoPath(outputPath))
+    {
+        return mRawWriter.open(outputPath,
+                               mControlNode->capGet(cv::CAP_PROP_FPS),
+                               cv::Size(mControlNode->capGet(cv::CAP_PROP_FRAME_WIDTH), mControlNode->capGet(cv::CAP_PROP_FRAME_HEIGHT)));
+    }
+
     // Default to mp4v codec
     int fourccFormat = cv::VideoWriter::fourcc('m', 'p', '4', 'v');
 
@@ -229,12 +301,220 @@ bool OutputNode::loadWriter(const std::string &outputPath, const std::string &fo
                                        cv::Size(mControlNode->capGet(cv::CAP_PROP_FRAME_WIDTH), mControlNode->capGet(cv::CAP_PROP_FRAME_HEIGHT)));
     }
 
+    // Encode with the codec share of the thread budget, where the backend supports it
+    if (mVideoWriter.isOpened())
+    {
+        mVideoWriter.set(cv::VIDEOWRITER_PROP_NSTRIPES, mControlNode->threadBudgetGet().codec);
+    }
+
     // Check if the writer was opened successfully
     return mVideoWriter.isOpened();
 }
 
 // Capture and save a single frame with highlighted objects
-void OutputNode::captureFrameWithHighlights(const std::string &outputPath, const cv::Mat &frame)
+// The frame is encoded in the background, so playback never waits for it
+void OutputNode::captureFrameWithHighlights(Frame &frame)
+{
+    if (!mSnapshotWriter)
+    {
+        return;
+    }
+
+    // Frames tracked on luma are only rendered up front when every frame is shown,
+    // others are rendered and highlighted here when a snapshot or burst wants them
+    if (frame.image.empty() && !frame.native.empty())
+    {
+        frameRender(frame);
+        frameHighlight(frame);
+        frameLeaseUpdate(frame);
+    }
+
+    if (!frame.image.empty())
+    {
+        mSnapshotWriter->capture(frame);
+    }
+}
+
+// Check if the frame is one of the frames of the preset burst or the one started with 'b'
+bool OutputNode::burstWanted(int idx) const
+{
+    return burstContains(mBurst, idx) || burstContains(mKeyBurst, idx);
+}
+
+// Publish the rendered frame and its boxes to shared memory if enabled
+void OutputNode::publishFrame(const Frame &frame)
+{
+    if (mShmName.empty() || frame.image.empty())
+    {
+        return;
+    }
+
+    // Open the segment once the frame size is known
+    // A segment of another size is unmapped and removed first, so the new one gets the name
+    if (!mShmSink || !mShmSink->matches(frame.image))
+    {
+        mShmSink.reset();
+        mShmSink = std::make_unique<ShmSink>();
+        if (!mShmSink->open(mShmName, frame.image.cols, frame.image.rows, frame.image.channels()))
+        {
+            std::cerr << "Error: Could not open shared memory output: " << mShmName << std::endl;
+            mShmSink.reset();
+            mShmName.clear();
+            return;
+        }
+    }
+
+    mShmSink->publish(frame);
+}
+
+// Draw the capture-to-display age on a live frame and print statistics every second
+void OutputNode::reportFrameAge(Frame &frame)
+{
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> age = now - frame.readTime;
+
+    // Gaps in the frame indices are frames replaced by newer ones
+    if (mLiveLastIdx >= 0 && frame.idx > mLiveLastIdx + 1)
+    {
+        mLiveSkipped += frame.idx - mLiveLastIdx - 1;
+    }
+    mLiveLastIdx = frame.idx;
+    mLiveShown += 1;
+    mLiveAgeSum += age.count();
+    mLiveAgeMax = std::max(mLiveAgeMax, age.count());
+
+    if (frame.preview.empty())
+    {
+        frameImageWritable(frame);
+    }
+    cv::Mat &shown = frame.preview.empty() ? frame.image : frame.preview;
+    cv::putText(shown, "age " + std::to_string(static_cast<int>(age.count())) + " ms", cv::Point(10, 30),
+                cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 255, 255), 2);
+
+    if (now - mLiveReportTime >= std::chrono::seconds(1))
+    {
+        std::cout << "Live: " << mLiveShown << " frames shown, " << mLiveSkipped << " skipped, age avg "
+                  << mLiveAgeSum / mLiveShown << " ms, max " << mLiveAgeMax << " ms" << std::endl;
+        mLiveReportTime = now;
+        mLiveShown = 0;
+        mLiveSkipped = 0;
+        mLiveAgeSum = 0.0;
+        mLiveAgeMax = 0.0;
+    }
+}
+
+// Run the scripted actions due at the shown frame, as if their keys were pressed
+// Returns false if an action ended playback, true otherwise
+bool OutputNode::runScenario(Frame &frame)
+{
+    while (mScenarioNext < mScenario.actions.size() && frame.idx >= mScenario.actions[mScenarioNext].frame)
+    {
+        const ScenarioAction &action = mScenario.actions[mScenarioNext++];
+
+        auto start = std::chrono::steady_clock::now();
+        bool keepPlaying = true;
+        switch (action.type)
+        {
+        case ScenarioActionType::Select:
+        {
+            // Scripted boxes are in frame coordinates, clip them like selected ones
+            const cv::Mat &image = frameTrackingImage(frame);
+            cv::Rect bounds(0, 0, image.cols, image.rows);
+            std::vector<cv::Rect> boxes;
+            boxes.reserve(action.boxes.size());
+            for (const auto &box : action.boxes)
+            {
+                cv::Rect clipped = box & bounds;
+                if (clipped.empty())
+                {
+                    std::cerr << "Warning: Skipping scenario box " << box.x << "," << box.y << " " << box.width << "x"
+                              << box.height << " at frame " << frame.idx << ", it is outside the frame" << std::endl;
+                    continue;
+                }
+                boxes.push_back(clipped);
+            }
+            if (!boxes.empty())
+            {
+                mControlNode->trackersCreateAndRewind(image, boxes, frame.idx);
+            }
+            break;
+        }
+        case ScenarioActionType::Rewind:
+            rewindVideo(action.count);
+            break;
+        case ScenarioActionType::Save:
+            keepPlaying = handlePlaybackInput('s', frame);
+            break;
+        case ScenarioActionType::Snapshot:
+            keepPlaying = handlePlaybackInput('o', frame);
+            break;
+        case ScenarioActionType::Burst:
+            keepPlaying = handlePlaybackInput('b', frame);
+            break;
+        case ScenarioActionType::Quit:
+            keepPlaying = handlePlaybackInput('q', frame);
+            break;
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        mScenarioTimings.push_back({action, elapsed.count()});
+        mScenarioActionTime = start;
+        mScenarioResumePending = true;
+        std::cout << "Scenario line " << action.line << " at frame " << frame.idx << ": "
+                  << scenarioActionDescribe(action) << " took " << elapsed.count() << " ms" << std::endl;
+
+        if (!keepPlaying)
+        {
+            return false;
+        }
+
+        // Actions that moved the video wait for the first frame of the new position
+        if (mControlNode->generationGet() != frame.generation)
+        {
+            break;
+        }
+    }
+    return true;
+}
+
+// Record how long the pipeline took to show a frame after the last action
+void OutputNode::scenarioResume()
 {
-    cv::imwrite(outputPath, frame);
+    if (!mScenarioResumePending)
+    {
+        return;
+    }
+    mScenarioResumePending = false;
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - mScenarioActionTime;
+    mScenarioTimings.back().resumeMs = elapsed.count();
+}
+
+// Print the timings of the actions run and write the report file
+void OutputNode::scenarioFinish()
+{
+    if (mScenario.actions.empty())
+    {
+        return;
+    }
+
+    std::cout << "Scenario: " << mScenarioTimings.size() << " of " << mScenario.actions.size() << " actions run" << std::endl;
+    for (const auto &timing : mScenarioTimings)
+    {
+        std::cout << "  line " << timing.action.line << ", frame " << timing.action.frame << ", "
+                  << scenarioActionDescribe(timing.action) << ": " << timing.actionMs << " ms";
+        if (timing.resumeMs >= 0.0)
+        {
+            std::cout << ", next frame after " << timing.resumeMs << " ms";
+        }
+        std::cout << std::endl;
+    }
+
+    if (!mScenario.reportPath.empty() && !scenarioReportWrite(mScenario.reportPath, mScenarioTimings))
+    {
+        std::cerr << "Error: Could not write scenario report: " << mScenario.reportPath << std::endl;
+    }
+
+    // Report once
+    mScenario.actions.clear();
 }
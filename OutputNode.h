@@ -2,9 +2,16 @@
 #define OUTPUT_NODE_H
 
 #include "ControlNode.h"
+#include "CropExporter.h"
 #include "DataStructs.h"
+#include "RawVideo.h"
+#include "Scenario.h"
+#include "ShmSink.h"
+#include "SnapshotWriter.h"
 #include "ThreadSafeQueue.h"
 
+#include <chrono>
+#include <memory>
 #include <optional>
 #include <stop_token>
 #include <string>
@@ -17,31 +24,82 @@ class OutputNode
 {
 private:
     cv::VideoWriter mVideoWriter;
+    // Used instead of mVideoWriter when saving to a raw video file
+    RawVideoWriter mRawWriter;
     std::string mWindowName;
     std::string mSaveWindowName{"Saving..."};
     std::string mOutputPath;
     std::string mFormat{"mp4v"};
+    // Crops only exports skip the full-frame writer
+    ExportMode mExportMode{ExportMode::Full};
+    // No windows and no input, the video plays through once
+    bool mHeadless{false};
+    // Shared-memory output, opened on the first frame when a name is given
+    std::string mShmName;
+    std::unique_ptr<ShmSink> mShmSink;
+    // Snapshots ('o') and bursts are encoded in the background
+    std::shared_ptr<SnapshotWriter> mSnapshotWriter;
+    // Burst given up front, kept apart from the one started and stopped with 'b'
+    BurstRange mBurst;
+    BurstRange mKeyBurst;
+    // Frames between snapshots of a burst started with 'b'
+    int mBurstStep{10};
     std::shared_ptr<ControlNode> mControlNode;
     std::shared_ptr<ThreadSafeQueue<Frame>> mInputQueue;
     // No output queue needed for OutputNode
 
-    bool handlePlaybackInput(int key, const Frame &frame);
+    // Scripted actions, run in order as their frames are shown, and their timings
+    ScenarioSettings mScenario;
+    size_t mScenarioNext{0};
+    std::vector<ScenarioTiming> mScenarioTimings;
+    std::chrono::steady_clock::time_point mScenarioActionTime;
+    bool mScenarioResumePending{false};
+
+    // Live statistics since the last report
+    std::chrono::steady_clock::time_point mLiveReportTime;
+    int mLiveLastIdx{-1};
+    int mLiveShown{0};
+    int mLiveSkipped{0};
+    double mLiveAgeSum{0.0};
+    double mLiveAgeMax{0.0};
+
+    void outputFrame(Frame &frame);
+    bool handlePlaybackInput(int key, Frame &frame);
     void selectObjects(const Frame &frame);
     void rewindVideo(int frameCount);
     bool loadWriter(const std::string &outputPath, const std::string &fourcc);
-    void captureFrameWithHighlights(const std::string &filename, const cv::Mat &image);
+    void captureFrameWithHighlights(Frame &frame);
+    bool burstWanted(int idx) const;
+    void publishFrame(const Frame &frame);
+    void reportFrameAge(Frame &frame);
+    bool runScenario(Frame &frame);
+    void scenarioResume();
+    void scenarioFinish();
 
 public:
     OutputNode(const std::string &windowName,
                const std::string &outputPath,
                const std::string &format,
+               const std::string &shmName,
+               ExportMode exportMode,
+               bool headless,
+               std::shared_ptr<SnapshotWriter> snapshotWriter,
+               const BurstRange &burst,
+               const ScenarioSettings &scenario,
                std::shared_ptr<ControlNode> controlNode,
                std::shared_ptr<ThreadSafeQueue<Frame>> inputQueue)
         : mWindowName(windowName),
           mOutputPath(outputPath),
           mFormat(format),
+          mExportMode(exportMode),
+          mHeadless(headless),
+          mShmName(shmName),
+          mSnapshotWriter(snapshotWriter),
+          mBurst(burst),
+          mBurstStep(burst.step),
           mControlNode(controlNode),
-          mInputQueue(inputQueue) {}
+          mInputQueue(inputQueue),
+          mScenario(scenario) {}
     ~OutputNode() = default;
 
     OutputNode(const OutputNode &) = delete;
@@ -53,7 +111,7 @@ public:
     // Node concept methods
     std::optional<Frame> getFrame(std::stop_token st);
     void updateFrame(Frame &frame);
-    void passFrame(const Frame &frame, std::stop_token st);
+    void passFrame(Frame &&frame, std::stop_token st);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "QosController.h"
+
+#include <algorithm>
+#include <cmath>
+
+void QosController::configure(const QosSettings &settings)
+{
+    mSettings = settings;
+    mSettings.maxUpdateStride = std::max(mSettings.maxUpdateStride, mSettings.minUpdateStride);
+    mSettings.minPreviewScale = std::min(mSettings.minPreviewScale, mSettings.maxPreviewScale);
+    mSettings.maxPatchArea = std::max(mSettings.maxPatchArea, 1);
+    mSettings.minPatchArea = std::clamp(mSettings.minPatchArea, 1, mSettings.maxPatchArea);
+    mLevel = 0;
+    mLatencyEma = 0.0;
+    mLoadEma = 0.0;
+    mOverloadedFrames = 0;
+    mHeadroomFrames = 0;
+}
+
+bool QosController::enabled() const
+{
+    return mSettings.latencyTargetMs > 0.0;
+}
+
+bool QosController::update(double latencyMs, double load)
+{
+    if (!enabled())
+    {
+        return false;
+    }
+
+    // Smooth the latency and load so single slow frames do not trigger a step
+    constexpr double alpha = 0.2;
+    mLatencyEma = mLatencyEma == 0.0 ? latencyMs : alpha * latencyMs + (1.0 - alpha) * mLatencyEma;
+    mLoadEma = mLoadEma == 0.0 ? load : alpha * load + (1.0 - alpha) * mLoadEma;
+
+    // Tracking slower than the video means latency is about to grow even if it is fine now
+    bool overloaded = mLatencyEma > mSettings.latencyTargetMs || mLoadEma > 1.0;
+    bool headroom = mLatencyEma < 0.6 * mSettings.latencyTargetMs && mLoadEma < 0.6;
+
+    mOverloadedFrames = overloaded ? mOverloadedFrames + 1 : 0;
+    mHeadroomFrames = headroom ? mHeadroomFrames + 1 : 0;
+
+    int level = mLevel;
+    if (mOverloadedFrames >= sQosStepDownFrames)
+    {
+        level = std::min(mLevel + 1, sQosLevels);
+    }
+    else if (mHeadroomFrames >= sQosStepUpFrames)
+    {
+        level = std::max(mLevel - 1, 0);
+    }
+
+    if (level == mLevel)
+    {
+        return false;
+    }
+
+    // Give the new level time to take effect before judging it
+    mLevel = level;
+    mOverloadedFrames = 0;
+    mHeadroomFrames = 0;
+    return true;
+}
+
+int QosController::levelGet() const
+{
+    return mLevel;
+}
+
+QosLevel QosController::settingsGet() const
+{
+    // Interpolate between full quality (level 0) and the lowest quality
+    double t = static_cast<double>(mLevel) / sQosLevels;
+
+    QosLevel level;
+    level.updateStride = static_cast<int>(std::lround(mSettings.minUpdateStride + t * (mSettings.maxUpdateStride - mSettings.minUpdateStride)));
+    level.previewScale = mSettings.maxPreviewScale + t * (mSettings.minPreviewScale - mSettings.maxPreviewScale);
+    level.patchArea = static_cast<int>(std::lround(mSettings.maxPatchArea + t * (mSettings.minPatchArea - mSettings.maxPatchArea)));
+    return level;
+}
@@ -0,0 +1,62 @@
+#ifndef QOS_CONTROLLER
+#define QOS_CONTROLLER
+
+// User bounds for the adaptive quality-of-service controller
+struct QosSettings
+{
+    // Latency of the tracker stage to hold, 0 disables the controller
+    double latencyTargetMs{0.0};
+    // Frames between tracker updates at full and at lowest quality
+    int minUpdateStride{5};
+    int maxUpdateStride{20};
+    // Preview scale at full and at lowest quality
+    double maxPreviewScale{1.0};
+    double minPreviewScale{0.25};
+    // KCF patch area of the trackers at full and at lowest quality
+    int maxPatchArea{80 * 80};
+    int minPatchArea{32 * 32};
+};
+
+// Settings applied at one quality level
+struct QosLevel
+{
+    int updateStride;
+    double previewScale;
+    int patchArea;
+};
+
+// Number of steps between full and lowest quality
+constexpr int sQosLevels{4};
+// Consecutive frames over the target before stepping down
+constexpr int sQosStepDownFrames{5};
+// Consecutive frames with headroom before stepping back up
+constexpr int sQosStepUpFrames{30};
+
+// Feedback controller that trades tracking and display quality for latency
+// Steps down quickly under load and back up slowly once there is headroom
+class QosController
+{
+private:
+    QosSettings mSettings;
+    int mLevel{0};
+    double mLatencyEma{0.0};
+    double mLoadEma{0.0};
+    int mOverloadedFrames{0};
+    int mHeadroomFrames{0};
+
+public:
+    // Set the bounds and return to full quality
+    void configure(const QosSettings &settings);
+    // Check if a latency target was set
+    bool enabled() const;
+    // Feed the latency and the tracking load of one frame
+    // The load is the frame's tracking time over the frame period, above 1 tracking falls behind the video
+    // Returns true if the quality level changed
+    bool update(double latencyMs, double load);
+    // Get the current level, 0 is full quality
+    int levelGet() const;
+    // Get the settings of the current level
+    QosLevel settingsGet() const;
+};
+
+#endif
@@ -0,0 +1,204 @@
+#include "RawVideo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "opencv2/imgproc.hpp"
+#include "opencv2/videoio.hpp"
+
+bool isRawVideoPath(const std::string &path)
+{
+    return path.size() > sRawVideoExtension.size() &&
+           path.compare(path.size() - sRawVideoExtension.size(), sRawVideoExtension.size(), sRawVideoExtension) == 0;
+}
+
+RawVideoMapping::~RawVideoMapping()
+{
+    munmap(mData, mSize);
+}
+
+bool RawVideoReader::open(const std::string &path)
+{
+    release();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(RawVideoHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // Read-only mapping: the same frame can be in flight several times after a rewind,
+    // so frames are copied before anything is drawn into them
+    size_t size = static_cast<size_t>(st.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    auto mapping = std::make_shared<RawVideoMapping>(static_cast<uint8_t *>(data), size);
+    std::memcpy(&mHeader, mapping->data(), sizeof(RawVideoHeader));
+
+    // Validate the header against the file size
+    uint64_t frameBytes = uint64_t(mHeader.width) * mHeader.height * 3;
+    if (std::memcmp(mHeader.magic, sRawVideoMagic, sizeof(sRawVideoMagic)) != 0 ||
+        mHeader.frameStride < frameBytes || mHeader.frameStride % sRawVideoAlignment != 0 ||
+        mHeader.dataOffset % sRawVideoAlignment != 0 ||
+        mHeader.dataOffset + mHeader.frameCount * mHeader.frameStride > size)
+    {
+        return false;
+    }
+
+    // Frames are mostly read front to back
+    madvise(mapping->data(), size, MADV_SEQUENTIAL);
+
+    mMapping = std::move(mapping);
+    mPosition = 0;
+    return true;
+}
+
+bool RawVideoReader::isOpened() const
+{
+    return mMapping != nullptr;
+}
+
+void RawVideoReader::release()
+{
+    mMapping.reset();
+    mHeader = RawVideoHeader{};
+    mPosition = 0;
+}
+
+bool RawVideoReader::read(cv::Mat &image)
+{
+    if (!mMapping || mPosition >= mHeader.frameCount)
+    {
+        image = cv::Mat();
+        return false;
+    }
+
+    uint8_t *frame = mMapping->data() + mHeader.dataOffset + mPosition * mHeader.frameStride;
+    image = cv::Mat(static_cast<int>(mHeader.height), static_cast<int>(mHeader.width), CV_8UC3, frame);
+    mPosition += 1;
+    return true;
+}
+
+bool RawVideoReader::set(int propId, double value)
+{
+    if (!mMapping || propId != cv::CAP_PROP_POS_FRAMES || value < 0)
+    {
+        return false;
+    }
+
+    // Frames have a fixed stride, so seeking is just moving the position
+    mPosition = std::min(static_cast<uint64_t>(value), mHeader.frameCount);
+    return true;
+}
+
+double RawVideoReader::get(int propId) const
+{
+    switch (propId)
+    {
+    case cv::CAP_PROP_POS_FRAMES:
+        return static_cast<double>(mPosition);
+    case cv::CAP_PROP_FRAME_COUNT:
+        return static_cast<double>(mHeader.frameCount);
+    case cv::CAP_PROP_FPS:
+        return mHeader.fpsDen == 0 ? 0.0 : static_cast<double>(mHeader.fpsNum) / mHeader.fpsDen;
+    case cv::CAP_PROP_FRAME_WIDTH:
+        return mHeader.width;
+    case cv::CAP_PROP_FRAME_HEIGHT:
+        return mHeader.height;
+    default:
+        return 0.0;
+    }
+}
+
+bool RawVideoWriter::open(const std::string &path, double fps, cv::Size size)
+{
+    release();
+
+    mFile.open(path, std::ios::binary | std::ios::trunc);
+    if (!mFile.is_open())
+    {
+        return false;
+    }
+
+    // Frames start on page boundaries, also on systems with pages larger than the minimum
+    uint64_t alignment = std::max<uint64_t>(sRawVideoAlignment, static_cast<uint64_t>(sysconf(_SC_PAGESIZE)));
+    uint64_t frameBytes = uint64_t(size.width) * size.height * 3;
+    std::memcpy(mHeader.magic, sRawVideoMagic, sizeof(sRawVideoMagic));
+    mHeader.width = size.width;
+    mHeader.height = size.height;
+    mHeader.fpsNum = static_cast<uint32_t>(std::lround(fps * 1000.0));
+    mHeader.fpsDen = 1000;
+    mHeader.frameCount = 0;
+    mHeader.frameStride = (frameBytes + alignment - 1) / alignment * alignment;
+    mHeader.dataOffset = alignment;
+
+    // Header padded to the first frame
+    std::vector<char> header(mHeader.dataOffset, 0);
+    std::memcpy(header.data(), &mHeader, sizeof(RawVideoHeader));
+    mFile.write(header.data(), header.size());
+
+    mPadding.assign(mHeader.frameStride - frameBytes, 0);
+    return mFile.good();
+}
+
+bool RawVideoWriter::isOpened() const
+{
+    return mFile.is_open();
+}
+
+void RawVideoWriter::write(const cv::Mat &image)
+{
+    if (!mFile.is_open() || image.cols != static_cast<int>(mHeader.width) || image.rows != static_cast<int>(mHeader.height))
+    {
+        return;
+    }
+
+    // Store every frame as BGR24
+    cv::Mat bgr = image;
+    if (image.type() != CV_8UC3)
+    {
+        cv::cvtColor(image, bgr, cv::COLOR_GRAY2BGR);
+    }
+
+    // Write the rows, which may not be contiguous for sub-images
+    size_t rowBytes = bgr.cols * bgr.elemSize();
+    for (int r = 0; r < bgr.rows; ++r)
+    {
+        mFile.write(reinterpret_cast<const char *>(bgr.ptr(r)), rowBytes);
+    }
+    mFile.write(mPadding.data(), mPadding.size());
+
+    mHeader.frameCount += 1;
+}
+
+void RawVideoWriter::release()
+{
+    if (!mFile.is_open())
+    {
+        return;
+    }
+
+    // Patch the final frame count into the header
+    mFile.seekp(0);
+    mFile.write(reinterpret_cast<const char *>(&mHeader), sizeof(RawVideoHeader));
+    mFile.close();
+    mHeader = RawVideoHeader{};
+}
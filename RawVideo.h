@@ -0,0 +1,120 @@
+#ifndef RAW_VIDEO
+#define RAW_VIDEO
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+// File extension of raw videos
+static const std::string sRawVideoExtension = ".ohraw";
+
+// Header at the start of a raw video file
+// Frames are packed BGR24 and start on page boundaries so single
+// frames of the memory mapping can be handled independently
+struct RawVideoHeader
+{
+    char magic[8];
+    uint32_t width;
+    uint32_t height;
+    uint32_t fpsNum;
+    uint32_t fpsDen;
+    uint64_t frameCount;
+    uint64_t frameStride;
+    uint64_t dataOffset;
+};
+
+constexpr char sRawVideoMagic[8] = {'O', 'H', 'R', 'A', 'W', '0', '1', '\0'};
+// Smallest frame alignment a file may have, writers align to the page size if it is larger
+constexpr uint64_t sRawVideoAlignment{4096};
+
+// Check if the path names a raw video file
+bool isRawVideoPath(const std::string &path);
+
+// Read-only memory mapping of a raw video file
+// Frames hold a reference to it so the mapping outlives every image header
+class RawVideoMapping
+{
+private:
+    uint8_t *mData{nullptr};
+    size_t mSize{0};
+
+public:
+    RawVideoMapping(uint8_t *data, size_t size) : mData(data), mSize(size) {}
+    ~RawVideoMapping();
+
+    // Delete copy and move constructors and assignment operators
+    RawVideoMapping(const RawVideoMapping &) = delete;
+    RawVideoMapping &operator=(const RawVideoMapping &) = delete;
+    RawVideoMapping(RawVideoMapping &&) = delete;
+    RawVideoMapping &operator=(RawVideoMapping &&) = delete;
+
+    uint8_t *data() const { return mData; }
+    size_t size() const { return mSize; }
+};
+
+// Memory-mapped raw video reader with a subset of the cv::VideoCapture interface
+// read() returns image headers pointing straight into the read-only mapping,
+// frames that are drawn into get their own copy first (see frameImageWritable)
+class RawVideoReader
+{
+private:
+    std::shared_ptr<RawVideoMapping> mMapping;
+    RawVideoHeader mHeader{};
+    uint64_t mPosition{0};
+
+public:
+    RawVideoReader() = default;
+    ~RawVideoReader() = default;
+
+    // Open and map the raw video file
+    // Returns true if successful, false otherwise
+    bool open(const std::string &path);
+    // Check if a file is mapped
+    bool isOpened() const;
+    // Unmap the file, images that are still in use keep their frames mapped
+    void release();
+    // Point the image at the next frame without copying
+    // Returns false at the end of the video
+    bool read(cv::Mat &image);
+    // Only CAP_PROP_POS_FRAMES can be set, seeking is O(1)
+    bool set(int propId, double value);
+    // Supports position, frame count, fps, width and height
+    double get(int propId) const;
+    // Get the mapping backing the images returned by read()
+    std::shared_ptr<RawVideoMapping> mappingGet() const { return mMapping; }
+};
+
+// Raw video writer with a subset of the cv::VideoWriter interface
+class RawVideoWriter
+{
+private:
+    std::ofstream mFile;
+    RawVideoHeader mHeader{};
+    std::vector<char> mPadding;
+
+public:
+    RawVideoWriter() = default;
+    ~RawVideoWriter() { release(); }
+
+    RawVideoWriter(const RawVideoWriter &) = delete;
+    RawVideoWriter &operator=(const RawVideoWriter &) = delete;
+
+    RawVideoWriter(RawVideoWriter &&) noexcept = default;
+    RawVideoWriter &operator=(RawVideoWriter &&) noexcept = default;
+
+    // Create the file and write the header
+    // Returns true if successful, false otherwise
+    bool open(const std::string &path, double fps, cv::Size size);
+    // Check if the file is open
+    bool isOpened() const;
+    // Append a BGR frame of the size given to open()
+    void write(const cv::Mat &image);
+    // Write the final frame count and close the file
+    void release();
+};
+
+#endif
@@ -2,8 +2,29 @@
 
 std::optional<Frame> ReaderNode::getFrame(std::stop_token st)
 {
-    Frame frame;
-    mControlNode->capReadAndGet(frame);
+    // Decode into the buffers of a frame the output is done with
+    Frame frame = mControlNode->frameSpare();
+
+    // Reserve room for the next frame before decoding it
+    // Blocks while the frames in flight use up the memory budget
+    if (!mFrameBudget->acquire(frame.lease, mFrameBytes, st))
+    {
+        return std::nullopt;
+    }
+
+    if (mControlNode->capReadAndGet(frame))
+    {
+        // Account for the real size of the frame, native frames are smaller than BGR
+        // A recycled frame also brings its rendered image and preview, reserved for the next frame too
+        mFrameBytes = frameBytes(frame);
+        frame.lease->resize(mFrameBytes);
+    }
+    else
+    {
+        // Nothing was decoded, the end of video signal holds no bytes
+        frame.lease->resize(0);
+    }
+
     return frame;
 }
 
@@ -11,13 +32,24 @@ void ReaderNode::updateFrame(Frame &frame)
 {
 }
 
-void ReaderNode::passFrame(const Frame &frame, std::stop_token st)
+void ReaderNode::passFrame(Frame &&frame, std::stop_token st)
 {
-    mOutputQueue->push(frame, st);
+    int idx = frame.idx;
+    uint32_t generation = frame.generation;
+
+    // Live sources replace a frame the tracker has not picked up yet
+    if (mControlNode->capIsLive())
+    {
+        mOutputQueue->pushLatest(std::move(frame));
+    }
+    else
+    {
+        mOutputQueue->push(std::move(frame), st);
+    }
 
-    if (frame.idx == -1)
+    if (idx == -1)
     {
         // End of video signal, wait for generation change
-        mControlNode->generationWait(frame.generation);
+        mControlNode->generationWait(generation);
     }
 }
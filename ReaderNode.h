@@ -3,6 +3,7 @@
 
 #include "ControlNode.h"
 #include "DataStructs.h"
+#include "FrameBudget.h"
 #include "ThreadSafeQueue.h"
 
 #include "opencv2/videoio.hpp"
@@ -13,12 +14,17 @@ private:
     std::shared_ptr<ControlNode> mControlNode;
     std::shared_ptr<ThreadSafeQueue<Frame>> mOutputQueue;
     // No input queue needed for ReaderNode
+    std::shared_ptr<FrameBudget> mFrameBudget;
+    // Size of the last decoded frame, reserved before decoding the next one
+    size_t mFrameBytes{0};
 
 public:
     ReaderNode(std::shared_ptr<ControlNode> controlNode,
-               std::shared_ptr<ThreadSafeQueue<Frame>> outputQueue)
+               std::shared_ptr<ThreadSafeQueue<Frame>> outputQueue,
+               std::shared_ptr<FrameBudget> frameBudget)
         : mControlNode(controlNode),
-          mOutputQueue(outputQueue) {}
+          mOutputQueue(outputQueue),
+          mFrameBudget(frameBudget) {}
     ~ReaderNode() = default;
 
     ReaderNode(const ReaderNode &) = delete;
@@ -30,7 +36,7 @@ public:
     // Node concept methods
     std::optional<Frame> getFrame(std::stop_token st);
     void updateFrame(Frame &frame);
-    void passFrame(const Frame &frame, std::stop_token st);
+    void passFrame(Frame &&frame, std::stop_token st);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,119 @@
+#ifndef RESULTS_FORMAT
+#define RESULTS_FORMAT
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Layout of the binary tracking results file
+//
+// The file starts with a ResultsFileHeader followed by blocks. Each block
+// starts with a ResultsBlockHeader and holds rowCount rows stored column by
+// column: frame, id, x, y, width, height as int32 arrays, then active as a
+// uint8 array padded to a multiple of 4 bytes. One row is one tracker in
+// one frame. Blocks are appended while tracking, a block cut short by a
+// crash is ignored by the loader.
+
+constexpr char sResultsMagic[8] = {'O', 'H', 'R', 'E', 'S', '0', '1', '\0'};
+constexpr uint32_t sResultsVersion{1};
+constexpr uint32_t sResultsBlockMagic{0x4B4C4252}; // "RBLK"
+
+struct ResultsFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct ResultsBlockHeader
+{
+    uint32_t magic;
+    uint32_t rowCount;
+};
+
+// Bytes of the columns of a block with the given number of rows
+inline size_t resultsBlockBytes(uint32_t rowCount)
+{
+    return size_t(rowCount) * 6 * sizeof(int32_t) + (size_t(rowCount) + 3) / 4 * 4;
+}
+
+// All rows of a results file, column by column
+struct ResultsColumns
+{
+    std::vector<int32_t> frame;
+    std::vector<int32_t> id;
+    std::vector<int32_t> x;
+    std::vector<int32_t> y;
+    std::vector<int32_t> width;
+    std::vector<int32_t> height;
+    std::vector<uint8_t> active;
+
+    size_t size() const { return frame.size(); }
+};
+
+// Load a binary results file into columns
+// Reads the file in one go and copies every column of a block with a single memcpy
+// Returns true if successful, false if the file is missing or not a results file
+inline bool resultsLoad(const std::string &path, ResultsColumns &columns)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    std::vector<char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), data.size());
+
+    ResultsFileHeader header;
+    if (data.size() < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, sResultsMagic, sizeof(sResultsMagic)) != 0 || header.version != sResultsVersion)
+    {
+        return false;
+    }
+
+    columns = ResultsColumns{};
+    size_t offset = sizeof(header);
+    while (offset + sizeof(ResultsBlockHeader) <= data.size())
+    {
+        ResultsBlockHeader block;
+        std::memcpy(&block, data.data() + offset, sizeof(block));
+        size_t bytes = resultsBlockBytes(block.rowCount);
+        if (block.magic != sResultsBlockMagic || offset + sizeof(block) + bytes > data.size())
+        {
+            // Truncated or damaged block, keep what was complete
+            break;
+        }
+        offset += sizeof(block);
+
+        // Append one column of the block
+        auto append = [&](auto &column)
+        {
+            using T = typename std::decay_t<decltype(column)>::value_type;
+            size_t old = column.size();
+            column.resize(old + block.rowCount);
+            std::memcpy(column.data() + old, data.data() + offset, block.rowCount * sizeof(T));
+            offset += block.rowCount * sizeof(T);
+        };
+        append(columns.frame);
+        append(columns.id);
+        append(columns.x);
+        append(columns.y);
+        append(columns.width);
+        append(columns.height);
+        append(columns.active);
+        offset += (4 - block.rowCount % 4) % 4;
+    }
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,159 @@
+#include "ResultsWriter.h"
+
+#include <chrono>
+#include <iostream>
+
+bool ResultsWriter::open(const std::string &path)
+{
+    close();
+
+    mFile.open(path, std::ios::binary | std::ios::trunc);
+    if (!mFile.is_open())
+    {
+        return false;
+    }
+
+    const std::string jsonExtension = ".jsonl";
+    mJsonLines = path.size() > jsonExtension.size() &&
+                 path.compare(path.size() - jsonExtension.size(), jsonExtension.size(), jsonExtension) == 0;
+
+    if (!mJsonLines)
+    {
+        ResultsFileHeader header{};
+        std::memcpy(header.magic, sResultsMagic, sizeof(sResultsMagic));
+        header.version = sResultsVersion;
+        mFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+
+    mRowsWritten = 0;
+    mWriter = std::jthread([this](std::stop_token st)
+                           { writeBlocks(st); });
+    return mFile.good();
+}
+
+void ResultsWriter::record(int frameIdx, const std::vector<TrackerResult> &results)
+{
+    if (results.empty())
+    {
+        return;
+    }
+
+    bool full = false;
+    {
+        std::scoped_lock lock(mMutex);
+        for (const auto &result : results)
+        {
+            mCurrent.frame.push_back(frameIdx);
+            mCurrent.id.push_back(result.id);
+            mCurrent.x.push_back(result.box.x);
+            mCurrent.y.push_back(result.box.y);
+            mCurrent.width.push_back(result.box.width);
+            mCurrent.height.push_back(result.box.height);
+            mCurrent.active.push_back(result.active ? 1 : 0);
+        }
+
+        // Hand a full block to the writer and start a new one
+        if (mCurrent.size() >= sResultsBlockRows)
+        {
+            mBlocks.push_back(std::move(mCurrent));
+            mCurrent = ResultsColumns{};
+            full = true;
+        }
+    }
+
+    if (full)
+    {
+        mBlockCv.notify_one();
+    }
+}
+
+void ResultsWriter::close()
+{
+    // The writer thread writes the remaining rows when stopped
+    if (!mWriter.joinable())
+    {
+        return;
+    }
+    mWriter = std::jthread();
+    mFile.close();
+
+    std::cout << "Wrote " << mRowsWritten << " tracker results" << std::endl;
+}
+
+void ResultsWriter::writeBlocks(std::stop_token st)
+{
+    while (true)
+    {
+        std::deque<ResultsColumns> blocks;
+        bool stopping = false;
+        {
+            std::unique_lock lock(mMutex);
+
+            // Wake for a full block, or after a while to write a partial one
+            mBlockCv.wait_for(lock, st, std::chrono::milliseconds(sResultsFlushMs), [this]
+                              { return !mBlocks.empty(); });
+            stopping = st.stop_requested();
+
+            blocks.swap(mBlocks);
+            if (mCurrent.size() > 0)
+            {
+                blocks.push_back(std::move(mCurrent));
+                mCurrent = ResultsColumns{};
+            }
+        }
+
+        // Write outside the lock, so recording never waits for the file
+        for (const auto &block : blocks)
+        {
+            writeBlock(block);
+        }
+        mFile.flush();
+
+        if (stopping)
+        {
+            return;
+        }
+    }
+}
+
+void ResultsWriter::writeBlock(const ResultsColumns &block)
+{
+    uint32_t rows = static_cast<uint32_t>(block.size());
+    mRowsWritten += rows;
+
+    if (mJsonLines)
+    {
+        // One line per frame with all of its objects
+        std::string line;
+        for (uint32_t i = 0; i < rows; ++i)
+        {
+            bool first = i == 0 || block.frame[i] != block.frame[i - 1];
+            line += first ? "{\"frame\":" + std::to_string(block.frame[i]) + ",\"objects\":[" : ",";
+            line += "{\"id\":" + std::to_string(block.id[i]) + ",\"x\":" + std::to_string(block.x[i]) +
+                    ",\"y\":" + std::to_string(block.y[i]) + ",\"width\":" + std::to_string(block.width[i]) +
+                    ",\"height\":" + std::to_string(block.height[i]) +
+                    ",\"active\":" + (block.active[i] ? "true" : "false") + "}";
+
+            bool last = i + 1 == rows || block.frame[i + 1] != block.frame[i];
+            if (last)
+            {
+                line += "]}\n";
+                mFile.write(line.data(), line.size());
+                line.clear();
+            }
+        }
+        return;
+    }
+
+    // Columns one after the other, see ResultsFormat.h
+    ResultsBlockHeader header{sResultsBlockMagic, rows};
+    mFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto *column : {&block.frame, &block.id, &block.x, &block.y, &block.width, &block.height})
+    {
+        mFile.write(reinterpret_cast<const char *>(column->data()), rows * sizeof(int32_t));
+    }
+    mFile.write(reinterpret_cast<const char *>(block.active.data()), rows);
+
+    const char padding[4] = {0, 0, 0, 0};
+    mFile.write(padding, (4 - rows % 4) % 4);
+}
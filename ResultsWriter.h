@@ -0,0 +1,61 @@
+#ifndef RESULTS_WRITER
+#define RESULTS_WRITER
+
+#include "DataStructs.h"
+#include "ResultsFormat.h"
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Rows collected before a block is handed to the writer thread
+constexpr size_t sResultsBlockRows{4096};
+// Longest time recorded rows wait before they are written anyway
+constexpr int sResultsFlushMs{500};
+
+// Streams the tracker results of every frame to a file in the background
+// Files ending in .jsonl get one JSON object per frame, other files the
+// binary columnar format described in ResultsFormat.h
+class ResultsWriter
+{
+private:
+    std::ofstream mFile;
+    bool mJsonLines{false};
+
+    // Rows being collected, and full blocks waiting for the writer thread
+    std::mutex mMutex;
+    std::condition_variable_any mBlockCv;
+    ResultsColumns mCurrent;
+    std::deque<ResultsColumns> mBlocks;
+    std::jthread mWriter;
+    size_t mRowsWritten{0};
+
+    // Write blocks until stopped, then write whatever is left
+    void writeBlocks(std::stop_token st);
+    // Append one block to the file in the chosen format
+    void writeBlock(const ResultsColumns &block);
+
+public:
+    ResultsWriter() = default;
+    ~ResultsWriter() { close(); }
+
+    // Delete copy and move constructors and assignment operators
+    ResultsWriter(const ResultsWriter &) = delete;
+    ResultsWriter &operator=(const ResultsWriter &) = delete;
+    ResultsWriter(ResultsWriter &&) = delete;
+    ResultsWriter &operator=(ResultsWriter &&) = delete;
+
+    // Create the file and start the writer thread
+    // Returns true if successful, false otherwise
+    bool open(const std::string &path);
+    // Record the results of a frame, never waits for the file
+    void record(int frameIdx, const std::vector<TrackerResult> &results);
+    // Write all recorded rows and close the file
+    void close();
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef RING_QUEUE
+#define RING_QUEUE
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Double-ended queue on a ring buffer, not thread safe
+// Slots are reused once popped, so a queue that stays within its capacity
+// never allocates, unlike std::deque which allocates as its blocks fill up.
+// Grows by doubling when full.
+template <typename T>
+class RingQueue
+{
+private:
+    std::vector<T> mItems;
+    size_t mHead{0};
+    size_t mSize{0};
+
+    // Move the items into a buffer twice as large, the head moves to slot 0
+    void grow()
+    {
+        std::vector<T> items(mItems.empty() ? 1 : mItems.size() * 2);
+        for (size_t i = 0; i < mSize; ++i)
+        {
+            items[i] = std::move(mItems[(mHead + i) % mItems.size()]);
+        }
+        mItems = std::move(items);
+        mHead = 0;
+    }
+
+public:
+    // Constructor with the number of items that fit before the queue has to grow
+    explicit RingQueue(size_t capacity = 0) : mItems(capacity) {}
+
+    bool empty() const { return mSize == 0; }
+    size_t size() const { return mSize; }
+    size_t capacity() const { return mItems.size(); }
+
+    T &front() { return mItems[mHead]; }
+    const T &front() const { return mItems[mHead]; }
+
+    void push_back(T &&value)
+    {
+        if (mSize == mItems.size())
+        {
+            grow();
+        }
+        mItems[(mHead + mSize) % mItems.size()] = std::move(value);
+        mSize += 1;
+    }
+
+    void push_front(T &&value)
+    {
+        if (mSize == mItems.size())
+        {
+            grow();
+        }
+        mHead = (mHead + mItems.size() - 1) % mItems.size();
+        mItems[mHead] = std::move(value);
+        mSize += 1;
+    }
+
+    // Remove the front item, its slot is reset so it does not hold on to resources
+    void pop_front()
+    {
+        mItems[mHead] = T();
+        mHead = (mHead + 1) % mItems.size();
+        mSize -= 1;
+    }
+
+    // Remove every item, keeping the capacity
+    void clear()
+    {
+        while (!empty())
+        {
+            pop_front();
+        }
+        mHead = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "Scenario.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Parse "x,y,w,h" into a box with a positive size
+static bool parseBox(const std::string &text, cv::Rect &box)
+{
+    char c1 = 0;
+    char c2 = 0;
+    char c3 = 0;
+    std::stringstream ss(text);
+    if (!(ss >> box.x >> c1 >> box.y >> c2 >> box.width >> c3 >> box.height) || c1 != ',' || c2 != ',' || c3 != ',')
+    {
+        return false;
+    }
+    return box.width > 0 && box.height > 0 && ss.eof();
+}
+
+bool scenarioLoad(const std::string &path, std::vector<ScenarioAction> &actions)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Error: Could not open scenario: " << path << std::endl;
+        return false;
+    }
+
+    actions.clear();
+    std::string text;
+    int lineNumber = 0;
+    while (std::getline(file, text))
+    {
+        lineNumber += 1;
+        text = text.substr(0, text.find('#'));
+
+        std::stringstream line(text);
+        std::string name;
+        ScenarioAction action{0, ScenarioActionType::Quit};
+        action.line = lineNumber;
+        if (!(line >> action.frame))
+        {
+            // Blank and comment lines have no frame index
+            if (text.find_first_not_of(" \t\r") == std::string::npos)
+            {
+                continue;
+            }
+            std::cerr << "Error: " << path << ":" << lineNumber << ": expected a frame index" << std::endl;
+            return false;
+        }
+
+        bool ok = action.frame >= 0 && static_cast<bool>(line >> name);
+        std::string argument;
+        if (ok && name == "select")
+        {
+            action.type = ScenarioActionType::Select;
+            while (ok && line >> argument)
+            {
+                cv::Rect box;
+                ok = parseBox(argument, box);
+                action.boxes.push_back(box);
+            }
+            ok = ok && !action.boxes.empty();
+        }
+        else if (ok && name == "rewind")
+        {
+            action.type = ScenarioActionType::Rewind;
+            ok = static_cast<bool>(line >> argument);
+            if (ok && argument == "start")
+            {
+                action.count = -1;
+            }
+            else if (ok)
+            {
+                std::stringstream count(argument);
+                ok = count >> action.count && count.eof() && action.count > 0;
+            }
+        }
+        else if (ok && (name == "save" || name == "snapshot" || name == "burst" || name == "quit"))
+        {
+            action.type = name == "save"       ? ScenarioActionType::Save
+                          : name == "snapshot" ? ScenarioActionType::Snapshot
+                          : name == "burst"    ? ScenarioActionType::Burst
+                                               : ScenarioActionType::Quit;
+        }
+        else
+        {
+            ok = false;
+        }
+
+        // Nothing may follow the arguments
+        if (!ok || line >> argument)
+        {
+            std::cerr << "Error: " << path << ":" << lineNumber << ": invalid action: " << text << std::endl;
+            return false;
+        }
+        actions.push_back(std::move(action));
+    }
+
+    return true;
+}
+
+std::string scenarioActionDescribe(const ScenarioAction &action)
+{
+    switch (action.type)
+    {
+    case ScenarioActionType::Select:
+        return "select " + std::to_string(action.boxes.size()) + (action.boxes.size() == 1 ? " box" : " boxes");
+    case ScenarioActionType::Rewind:
+        return action.count < 0 ? "rewind start" : "rewind " + std::to_string(action.count);
+    case ScenarioActionType::Save:
+        return "save";
+    case ScenarioActionType::Snapshot:
+        return "snapshot";
+    case ScenarioActionType::Burst:
+        return "burst";
+    case ScenarioActionType::Quit:
+        return "quit";
+    }
+    return "";
+}
+
+bool scenarioReportWrite(const std::string &path, const std::vector<ScenarioTiming> &timings)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file << "line,frame,action,action_ms,resume_ms" << std::endl;
+    for (const auto &timing : timings)
+    {
+        file << timing.action.line << "," << timing.action.frame << "," << scenarioActionDescribe(timing.action) << ","
+             << timing.actionMs << "," << timing.resumeMs << std::endl;
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,70 @@
+#ifndef SCENARIO
+#define SCENARIO
+
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+// Scripted interaction for reproducible runs
+//
+// A scenario file lists one action per line as "<frame> <action> [arguments]",
+// '#' starts a comment. Actions run in file order, each on the first shown
+// frame at or after its frame index:
+//
+//   <frame> select x,y,w,h [x,y,w,h ...]   track these boxes (full resolution)
+//   <frame> rewind <frames>|start          rewind by a number of frames or to the start
+//   <frame> save                           start a save, as the 's' key
+//   <frame> snapshot                       save a snapshot, as the 'o' key
+//   <frame> burst                          start or stop a burst, as the 'b' key
+//   <frame> quit                           stop playback, as the 'q' key
+
+enum class ScenarioActionType
+{
+    Select,
+    Rewind,
+    Save,
+    Snapshot,
+    Burst,
+    Quit
+};
+
+struct ScenarioAction
+{
+    int frame;
+    ScenarioActionType type;
+    // Frames to rewind, -1 for the start
+    int count{0};
+    std::vector<cv::Rect> boxes;
+    // Line in the file, for reports
+    int line{0};
+};
+
+// Actions of a scenario and where to write their timings (empty for no file)
+struct ScenarioSettings
+{
+    std::vector<ScenarioAction> actions;
+    std::string reportPath;
+};
+
+// Time an action took and how long until the next frame was shown after it
+// For actions that seek or flush the pipeline the second one covers the refill
+struct ScenarioTiming
+{
+    ScenarioAction action;
+    double actionMs{0.0};
+    double resumeMs{-1.0};
+};
+
+// Load the actions of a scenario file
+// Returns true if successful, false with a message naming the bad line otherwise
+bool scenarioLoad(const std::string &path, std::vector<ScenarioAction> &actions);
+
+// Short description of an action, e.g. "rewind 300"
+std::string scenarioActionDescribe(const ScenarioAction &action);
+
+// Write the timings as CSV: line, frame, action, action_ms, resume_ms
+// Returns true if successful, false otherwise
+bool scenarioReportWrite(const std::string &path, const std::vector<ScenarioTiming> &timings);
+
+#endif
@@ -0,0 +1,102 @@
+#include "SceneDetector.h"
+
+#include <utility>
+
+#include "opencv2/imgproc.hpp"
+
+SceneChange SceneDetector::classify(const cv::Mat &image)
+{
+    if (image.empty())
+    {
+        return SceneChange::Normal;
+    }
+
+    // Downscale first so the color conversion only touches a few pixels
+    cv::resize(image, mSmall, cv::Size(sSceneWidth, sSceneHeight), 0, 0, cv::INTER_AREA);
+    if (mSmall.channels() == 3)
+    {
+        cv::cvtColor(mSmall, mLuma, cv::COLOR_BGR2GRAY);
+    }
+    else
+    {
+        mSmall.copyTo(mLuma);
+    }
+
+    // Normalized 32 bin luma histogram
+    constexpr int histSize = 32;
+    const float range[] = {0, 256};
+    const float *ranges[] = {range};
+    const int channels[] = {0};
+    cv::calcHist(&mLuma, 1, channels, cv::Mat(), mHist, 1, &histSize, ranges);
+    cv::normalize(mHist, mHist, 1.0, 0.0, cv::NORM_L1);
+
+    // First frame after a reset has nothing to compare against
+    if (mPreviousLuma.empty())
+    {
+        mLuma.copyTo(mPreviousLuma);
+        mHist.copyTo(mPreviousHist);
+        return SceneChange::Normal;
+    }
+
+    double area = static_cast<double>(mLuma.total());
+    double previousDiff = cv::norm(mLuma, mPreviousLuma, cv::NORM_L1) / area;
+    double histDistance = cv::compareHist(mHist, mPreviousHist, cv::HISTCMP_BHATTACHARYYA);
+
+    SceneChange change = SceneChange::Normal;
+    if (previousDiff > sCutMeanDiff && histDistance > sCutHistDistance)
+    {
+        change = SceneChange::Cut;
+    }
+
+    std::swap(mLuma, mPreviousLuma);
+    std::swap(mHist, mPreviousHist);
+
+    return change;
+}
+
+void SceneDetector::reset()
+{
+    mPreviousLuma.release();
+    mPreviousHist.release();
+}
+
+double RegionDetector::difference(const cv::Mat &image, const cv::Rect &box)
+{
+    // The box with half its size around it, so the object moving inside shows
+    cv::Rect region = cv::Rect(box.x - box.width / 2, box.y - box.height / 2, box.width * 2, box.height * 2) &
+                      cv::Rect(0, 0, image.cols, image.rows);
+    if (region.empty())
+    {
+        mLuma.release();
+        return -1.0;
+    }
+
+    cv::resize(image(region), mSmall, cv::Size(sRegionSize, sRegionSize), 0, 0, cv::INTER_AREA);
+    if (mSmall.channels() == 3)
+    {
+        cv::cvtColor(mSmall, mLuma, cv::COLOR_BGR2GRAY);
+    }
+    else
+    {
+        mSmall.copyTo(mLuma);
+    }
+
+    if (mReference.empty())
+    {
+        return -1.0;
+    }
+    return cv::norm(mLuma, mReference, cv::NORM_L1) / static_cast<double>(mLuma.total());
+}
+
+void RegionDetector::keep()
+{
+    if (!mLuma.empty())
+    {
+        mLuma.copyTo(mReference);
+    }
+}
+
+void RegionDetector::reset()
+{
+    mReference.release();
+}
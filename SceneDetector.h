@@ -0,0 +1,65 @@
+#ifndef SCENE_DETECTOR
+#define SCENE_DETECTOR
+
+#include "opencv2/core.hpp"
+
+// Size of the downscaled luma image used for comparisons
+constexpr int sSceneWidth{64};
+constexpr int sSceneHeight{36};
+// Bhattacharyya distance between luma histograms above which a frame is a cut
+constexpr double sCutHistDistance{0.5};
+// Mean absolute luma difference above which a frame can be a cut
+constexpr double sCutMeanDiff{25.0};
+// Side of the downscaled luma image of a tracker's region
+constexpr int sRegionSize{32};
+// Mean absolute luma difference below which a tracker's region is static
+constexpr double sStaticMeanDiff{1.0};
+// Mean absolute luma difference below which a lost tracker's region is back
+constexpr double sReturnMeanDiff{10.0};
+
+// How a frame relates to the frames before it
+enum class SceneChange
+{
+    Normal,
+    Cut
+};
+
+// Cheap per-frame cut detector working on a downscaled luma image
+// Cuts are detected against the previous frame
+class SceneDetector
+{
+private:
+    cv::Mat mSmall;
+    cv::Mat mLuma;
+    cv::Mat mHist;
+    cv::Mat mPreviousLuma;
+    cv::Mat mPreviousHist;
+
+public:
+    // Classify the given frame and remember it for the next call
+    SceneChange classify(const cv::Mat &image);
+    // Forget previous frames, the next frame is classified as Normal
+    void reset();
+};
+
+// Change detector for the neighbourhood of one tracker's box
+// A small object moving in a still frame barely changes the whole frame,
+// so whether a tracker can skip its update is decided on its own region
+class RegionDetector
+{
+private:
+    cv::Mat mSmall;
+    cv::Mat mLuma;
+    cv::Mat mReference;
+
+public:
+    // Mean absolute luma difference between the region around the box and the reference
+    // Returns a negative value if there is no reference or the region is outside the image
+    double difference(const cv::Mat &image, const cv::Rect &box);
+    // Keep the region of the last difference call as the reference
+    void keep();
+    // Forget the reference
+    void reset();
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "SearchWindow.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool searchWindowModeParse(const std::string &text, SearchWindowMode &mode)
+{
+    if (text == "off")
+    {
+        mode = SearchWindowMode::Off;
+    }
+    else if (text == "view")
+    {
+        mode = SearchWindowMode::View;
+    }
+    else if (text == "gather")
+    {
+        mode = SearchWindowMode::Gather;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+// Rectangle of the given scale around the center of the box
+static cv::Rect scaledAround(const cv::Rect &box, double scale)
+{
+    int width = static_cast<int>(std::ceil(box.width * scale));
+    int height = static_cast<int>(std::ceil(box.height * scale));
+    return cv::Rect(box.x + box.width / 2 - width / 2, box.y + box.height / 2 - height / 2, width, height);
+}
+
+cv::Rect searchWindowFor(const cv::Rect &box, cv::Size frameSize)
+{
+    return scaledAround(box, sSearchWindowScale) & cv::Rect(0, 0, frameSize.width, frameSize.height);
+}
+
+void trackerInit(ObjectTracker &tracker, const cv::Mat &image, const cv::Rect &box, SearchWindowMode mode)
+{
+    tracker.mode = mode;
+    tracker.box = box;
+
+    // The region the object was selected in, a lost tracker comes back when it returns
+    tracker.region.reset();
+    tracker.region.difference(image, box);
+    tracker.region.keep();
+
+    if (mode == SearchWindowMode::Off)
+    {
+        tracker.window = cv::Rect();
+        tracker.tracker->init(image, box);
+        return;
+    }
+
+    // The tracker only ever sees its window, so it works in window coordinates
+    tracker.window = searchWindowFor(box, image.size());
+    tracker.tracker->init(image(tracker.window), box - tracker.window.tl());
+}
+
+bool trackerUpdate(ObjectTracker &tracker, const cv::Mat &image)
+{
+    if (tracker.mode == SearchWindowMode::Off)
+    {
+        return tracker.tracker->update(image, tracker.box);
+    }
+
+    // A view into the frame needs no copy, gathering copies the window into
+    // the tracker's own contiguous buffer so its rows are adjacent in memory
+    cv::Mat window = image(tracker.window);
+    if (tracker.mode == SearchWindowMode::Gather)
+    {
+        window.copyTo(tracker.windowBuffer);
+        window = tracker.windowBuffer;
+    }
+
+    cv::Rect local;
+    if (!tracker.tracker->update(window, local))
+    {
+        return false;
+    }
+    tracker.box = local + tracker.window.tl();
+
+    // Move the window once the sampled patch no longer fits inside it
+    // Initializing the tracker on a re-centred window would throw its model away
+    cv::Rect frame(0, 0, image.cols, image.rows);
+    cv::Rect patch = scaledAround(tracker.box, sSearchPatchScale) & frame;
+    if ((patch & tracker.window) != patch)
+    {
+        cv::Point shift(std::min(patch.x - tracker.window.x, 0) + std::max(patch.br().x - tracker.window.br().x, 0),
+                        std::min(patch.y - tracker.window.y, 0) + std::max(patch.br().y - tracker.window.br().y, 0));
+        tracker.window = ((tracker.window + shift) | patch) & frame;
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef SEARCH_WINDOW
+#define SEARCH_WINDOW
+
+#include "DataStructs.h"
+
+#include <string>
+
+#include "opencv2/core.hpp"
+
+// Side of a tracker's search window relative to its box
+constexpr double sSearchWindowScale{5.0};
+// Side of the patch KCF samples around the box (1 + its default padding of 2.5)
+constexpr double sSearchPatchScale{3.5};
+
+// Parse "off", "view" or "gather"
+// Returns true if successful, false otherwise
+bool searchWindowModeParse(const std::string &text, SearchWindowMode &mode);
+
+// Padded window around a box, clipped to the frame
+cv::Rect searchWindowFor(const cv::Rect &box, cv::Size frameSize);
+
+// Initialize the tracker on the box, inside a search window unless the mode is Off
+void trackerInit(ObjectTracker &tracker, const cv::Mat &image, const cv::Rect &box, SearchWindowMode mode);
+
+// Update the tracker on its search window and translate the box back to frame coordinates
+// When the patch around the new box would leave the window, the window is moved just
+// far enough to hold it again. The tracker keeps its model and its window coordinates,
+// so on the next update it sees the object shifted by the move, no more than it moved
+// Returns true if the object was found, false otherwise
+bool trackerUpdate(ObjectTracker &tracker, const cv::Mat &image);
+
+#endif
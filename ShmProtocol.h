@@ -0,0 +1,75 @@
+#ifndef SHM_PROTOCOL
+#define SHM_PROTOCOL
+
+#include <atomic>
+#include <cstdint>
+
+// Layout of the shared-memory ring buffer used to hand rendered frames
+// to another process on the same host
+//
+// The segment starts with a ShmHeader followed by slotCount slots of
+// slotStride bytes. Each slot starts with a ShmSlotHeader followed by the
+// pixel rows (width * channels bytes each, no padding).
+//
+// Writer, for the n-th frame (n starting at 0) in slot n % slotCount:
+//   1. slot.sequence = 2n + 1   (odd: slot is being written)
+//   2. write boxes and pixels
+//   3. slot.sequence = 2n + 2   (release)
+//   4. header.published = n + 1 (release)
+// Reader:
+//   1. p = header.published (acquire), the newest frame is n = p - 1
+//   2. s1 = slot.sequence (acquire), must be 2n + 2
+//   3. copy boxes and pixels
+//   4. s2 = slot.sequence, the copy is valid if s1 == s2
+// The writer never waits for readers, a slow reader just skips frames.
+//
+// The header is valid once magic reads sShmMagic (acquire). The writer
+// stores it last (release). A segment is never resized: the writer clears
+// the magic of the old segment and unlinks it, then creates a new one
+// under the same name. Readers re-attach when the magic drops to 0, or when
+// no frame arrives for a while and the name refers to another segment.
+
+constexpr uint32_t sShmMagic{0x4F48534D}; // "OHSM"
+constexpr uint32_t sShmVersion{1};
+constexpr uint32_t sShmMaxBoxes{64};
+constexpr uint32_t sShmDefaultSlots{4};
+
+// Tracker box of a frame
+struct ShmBox
+{
+    int32_t id;
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+    int32_t active;
+};
+
+// Header at the start of every slot
+struct alignas(64) ShmSlotHeader
+{
+    std::atomic<uint64_t> sequence;
+    int64_t frameIndex;
+    int64_t timestampNs;
+    uint32_t boxCount;
+    ShmBox boxes[sShmMaxBoxes];
+};
+
+// Header at the start of the segment
+struct alignas(64) ShmHeader
+{
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t slotCount;
+    uint64_t slotStride;
+    uint64_t slotsOffset;
+    alignas(64) std::atomic<uint64_t> published;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared-memory protocol needs lock-free 64 bit atomics");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Shared-memory magic must keep the header layout");
+
+#endif
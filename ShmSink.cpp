@@ -0,0 +1,161 @@
+#include "ShmSink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void ShmSink::invalidate(const std::string &name)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(ShmHeader))
+    {
+        void *old = mmap(nullptr, sizeof(ShmHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (old != MAP_FAILED)
+        {
+            static_cast<ShmHeader *>(old)->magic.store(0, std::memory_order_release);
+            munmap(old, sizeof(ShmHeader));
+        }
+    }
+    ::close(fd);
+}
+
+ShmSlotHeader *ShmSink::slot(uint64_t n) const
+{
+    const ShmHeader *hdr = header();
+    return reinterpret_cast<ShmSlotHeader *>(mData + hdr->slotsOffset + (n % hdr->slotCount) * hdr->slotStride);
+}
+
+bool ShmSink::open(const std::string &name, int width, int height, int channels, uint32_t slots)
+{
+    close();
+
+    // Slots are cache line aligned so their headers never share a line
+    uint64_t pixelBytes = uint64_t(width) * height * channels;
+    uint64_t slotStride = (sizeof(ShmSlotHeader) + pixelBytes + 63) / 64 * 64;
+    uint64_t slotsOffset = sizeof(ShmHeader);
+    size_t size = slotsOffset + slotStride * slots;
+
+    // A segment left behind under this name is invalidated, so readers still mapped
+    // to it re-attach, and removed instead of resized under them
+    invalidate(name);
+    shm_unlink(name.c_str());
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    mName = name;
+    mData = static_cast<uint8_t *>(data);
+    mSize = size;
+
+    // Describe the layout, publishing nothing until the first frame
+    ShmHeader *hdr = header();
+    hdr->width = width;
+    hdr->height = height;
+    hdr->channels = channels;
+    hdr->slotCount = slots;
+    hdr->slotStride = slotStride;
+    hdr->slotsOffset = slotsOffset;
+    hdr->version = sShmVersion;
+    for (uint32_t i = 0; i < slots; ++i)
+    {
+        slot(i)->sequence.store(0, std::memory_order_relaxed);
+    }
+    hdr->published.store(0, std::memory_order_relaxed);
+
+    // Readers check the magic first, so it is stored last
+    hdr->magic.store(sShmMagic, std::memory_order_release);
+
+    return true;
+}
+
+bool ShmSink::matches(const cv::Mat &image) const
+{
+    const ShmHeader *hdr = header();
+    return isOpened() && image.cols == static_cast<int>(hdr->width) &&
+           image.rows == static_cast<int>(hdr->height) && image.channels() == static_cast<int>(hdr->channels);
+}
+
+void ShmSink::publish(const Frame &frame)
+{
+    if (!matches(frame.image) || frame.image.depth() != CV_8U)
+    {
+        return;
+    }
+
+    ShmHeader *hdr = header();
+    uint64_t n = hdr->published.load(std::memory_order_relaxed);
+    ShmSlotHeader *target = slot(n);
+
+    // Mark the slot as being written
+    target->sequence.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Metadata
+    target->frameIndex = frame.idx;
+    target->timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+    target->boxCount = static_cast<uint32_t>(std::min<size_t>(frame.results.size(), sShmMaxBoxes));
+    for (uint32_t i = 0; i < target->boxCount; ++i)
+    {
+        const TrackerResult &result = frame.results[i];
+        target->boxes[i] = {result.id, result.box.x, result.box.y, result.box.width, result.box.height, result.active ? 1 : 0};
+    }
+
+    // Pixels, row by row as the image may be a sub-image
+    uint8_t *pixels = reinterpret_cast<uint8_t *>(target) + sizeof(ShmSlotHeader);
+    size_t rowBytes = frame.image.cols * frame.image.elemSize();
+    for (int r = 0; r < frame.image.rows; ++r)
+    {
+        std::memcpy(pixels + r * rowBytes, frame.image.ptr(r), rowBytes);
+    }
+
+    // Complete the slot, then make it the newest frame
+    target->sequence.store(2 * n + 2, std::memory_order_release);
+    hdr->published.store(n + 1, std::memory_order_release);
+}
+
+void ShmSink::close()
+{
+    if (mData == nullptr)
+    {
+        return;
+    }
+
+    // Readers still mapped see the segment go away and re-attach
+    header()->magic.store(0, std::memory_order_release);
+    munmap(mData, mSize);
+    shm_unlink(mName.c_str());
+    mData = nullptr;
+    mSize = 0;
+    mName.clear();
+}
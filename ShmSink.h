@@ -0,0 +1,47 @@
+#ifndef SHM_SINK
+#define SHM_SINK
+
+#include "DataStructs.h"
+#include "ShmProtocol.h"
+
+#include <cstdint>
+#include <string>
+
+// Publishes rendered frames and their tracker boxes into a POSIX
+// shared-memory ring buffer (see ShmProtocol.h) without ever blocking
+class ShmSink
+{
+private:
+    std::string mName;
+    uint8_t *mData{nullptr};
+    size_t mSize{0};
+
+    ShmHeader *header() const { return reinterpret_cast<ShmHeader *>(mData); }
+    ShmSlotHeader *slot(uint64_t n) const;
+    // Clear the magic of a segment existing under the name, if any
+    static void invalidate(const std::string &name);
+
+public:
+    ShmSink() = default;
+    ~ShmSink() { close(); }
+
+    // Delete copy and move constructors and assignment operators
+    ShmSink(const ShmSink &) = delete;
+    ShmSink &operator=(const ShmSink &) = delete;
+    ShmSink(ShmSink &&) = delete;
+    ShmSink &operator=(ShmSink &&) = delete;
+
+    // Create the shared-memory segment for frames of the given size and channels
+    // Returns true if successful, false otherwise
+    bool open(const std::string &name, int width, int height, int channels, uint32_t slots = sShmDefaultSlots);
+    // Check if the segment is open
+    bool isOpened() const { return mData != nullptr; }
+    // Check if frames of this size and channels fit the segment
+    bool matches(const cv::Mat &image) const;
+    // Copy the frame and its tracker boxes into the next slot
+    void publish(const Frame &frame);
+    // Unmap and remove the segment
+    void close();
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include "SnapshotWriter.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+#include "opencv2/imgcodecs.hpp"
+
+bool burstRangeParse(const std::string &text, int step, BurstRange &range)
+{
+    int first = 0;
+    int last = 0;
+    char dash = 0;
+    std::stringstream ss(text);
+    if (!(ss >> first >> dash >> last) || dash != '-' || first < 0 || last < first || step < 1)
+    {
+        return false;
+    }
+
+    range = {first, last, step};
+    return true;
+}
+
+SnapshotWriter::SnapshotWriter(const SnapshotSettings &settings, int workers) : mSettings(settings)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(mSettings.directory, ec);
+
+    // Map the quality onto the encoder's own parameter
+    int quality = std::clamp(mSettings.quality, 0, 100);
+    if (mSettings.format == "jpg" || mSettings.format == "jpeg")
+    {
+        mParams = {cv::IMWRITE_JPEG_QUALITY, quality};
+    }
+    else if (mSettings.format == "webp")
+    {
+        mParams = {cv::IMWRITE_WEBP_QUALITY, std::max(quality, 1)};
+    }
+    else if (mSettings.format == "png")
+    {
+        mParams = {cv::IMWRITE_PNG_COMPRESSION, 9 - quality * 9 / 100};
+    }
+
+    for (int i = 0; i < std::max(workers, 1); ++i)
+    {
+        mWorkers.emplace_back([this](std::stop_token st)
+                              { encode(st); });
+    }
+}
+
+bool SnapshotWriter::capture(const Frame &frame)
+{
+    {
+        std::scoped_lock lock(mMutex);
+        if (mQueue.size() >= sSnapshotQueueFrames)
+        {
+            mDropped += 1;
+            std::cerr << "Warning: Snapshot queue full, frame " << frame.idx << " not saved." << std::endl;
+            return false;
+        }
+        mQueue.push_back({frame.idx, frame.image, frame.storage});
+    }
+    mQueueCv.notify_one();
+    return true;
+}
+
+void SnapshotWriter::encode(std::stop_token st)
+{
+    while (true)
+    {
+        Snapshot snapshot;
+        {
+            // A stop only ends the worker once the queue is empty
+            std::unique_lock lock(mMutex);
+            mQueueCv.wait(lock, st, [this]
+                          { return !mQueue.empty(); });
+            if (mQueue.empty())
+            {
+                return;
+            }
+            snapshot = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+
+        std::string path = mSettings.directory + "/frame_" + std::to_string(snapshot.idx) + "." + mSettings.format;
+        bool ok = !snapshot.image.empty() && cv::imwrite(path, snapshot.image, mParams);
+
+        std::scoped_lock lock(mMutex);
+        if (ok)
+        {
+            mWritten += 1;
+        }
+        else
+        {
+            mFailed += 1;
+            std::cerr << "Error: Could not write snapshot: " << path << std::endl;
+        }
+    }
+}
+
+void SnapshotWriter::close()
+{
+    if (mWorkers.empty())
+    {
+        return;
+    }
+
+    // Joining the workers waits for the queued snapshots
+    for (auto &worker : mWorkers)
+    {
+        worker.request_stop();
+    }
+    mWorkers.clear();
+
+    if (mWritten + mFailed + mDropped > 0)
+    {
+        std::cout << "Snapshots: " << mWritten << " written, " << mFailed << " failed, " << mDropped
+                  << " dropped" << std::endl;
+    }
+}
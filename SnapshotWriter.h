@@ -0,0 +1,94 @@
+#ifndef SNAPSHOT_WRITER
+#define SNAPSHOT_WRITER
+
+#include "DataStructs.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+// Snapshots waiting to be encoded before new ones are dropped
+constexpr size_t sSnapshotQueueFrames{32};
+
+// Where and how snapshots are written
+struct SnapshotSettings
+{
+    std::string directory{"."};
+    // Image file extension, e.g. jpg, png or webp
+    std::string format{"jpg"};
+    // 0-100, higher is better, for PNG lower quality compresses harder
+    int quality{95};
+};
+
+// Frames saved automatically during playback: every step-th frame from first to last
+struct BurstRange
+{
+    int first{-1};
+    int last{-1};
+    int step{1};
+};
+
+// Parse "FIRST-LAST" into a range with the given step
+// Returns true if successful, false otherwise
+bool burstRangeParse(const std::string &text, int step, BurstRange &range);
+
+// Check if the frame index is one of the range's frames
+inline bool burstContains(const BurstRange &range, int idx)
+{
+    return range.first >= 0 && idx >= range.first && idx <= range.last && (idx - range.first) % range.step == 0;
+}
+
+// Encodes snapshots of rendered frames to image files on background workers
+// Capturing never waits: frames are shared, not copied, and dropped when the queue is full
+class SnapshotWriter
+{
+private:
+    struct Snapshot
+    {
+        int idx;
+        cv::Mat image;
+        // Keeps external memory behind the image alive
+        std::shared_ptr<void> storage;
+    };
+
+    SnapshotSettings mSettings;
+    std::vector<int> mParams;
+
+    std::mutex mMutex;
+    std::condition_variable_any mQueueCv;
+    std::deque<Snapshot> mQueue;
+    std::vector<std::jthread> mWorkers;
+    int mWritten{0};
+    int mFailed{0};
+    int mDropped{0};
+
+    // Encode queued snapshots until stopped and the queue is empty
+    void encode(std::stop_token st);
+
+public:
+    // Start the given number of encoding workers
+    SnapshotWriter(const SnapshotSettings &settings, int workers);
+    ~SnapshotWriter() { close(); }
+
+    // Delete copy and move constructors and assignment operators
+    SnapshotWriter(const SnapshotWriter &) = delete;
+    SnapshotWriter &operator=(const SnapshotWriter &) = delete;
+    SnapshotWriter(SnapshotWriter &&) = delete;
+    SnapshotWriter &operator=(SnapshotWriter &&) = delete;
+
+    // Queue the frame's image as <directory>/frame_<idx>.<format>
+    // The image must not be changed afterwards
+    // Returns true if queued, false if the queue is full and the snapshot was dropped
+    bool capture(const Frame &frame);
+    // Encode everything queued, stop the workers and report the totals
+    void close();
+};
+
+#endif
@@ -0,0 +1,48 @@
+#include "ThreadBudget.h"
+
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+ThreadBudget threadBudgetSplit(int total, int opencvThreads, int poolCores)
+{
+    ThreadBudget budget;
+    budget.total = total > 0 ? total : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+    // The stages mostly wait, what is left is for the work they hand out
+    int rest = std::max(budget.total - budget.stages, 1);
+
+    // The decoder keeps the pipeline fed, a few threads are enough for it
+    budget.codec = std::clamp(rest / 4, 1, 4);
+    rest = std::max(rest - budget.codec, 1);
+
+    // A pinned pool cannot use more workers than it has cores
+    int maxPool = poolCores > 0 ? std::min(poolCores, sMaxThreads) : sMaxThreads;
+    if (opencvThreads >= 0)
+    {
+        budget.opencv = std::max(opencvThreads, 1);
+        budget.pool = std::clamp(rest - budget.opencv, 1, maxPool);
+    }
+    else
+    {
+        // Trackers scale best one per worker, OpenCV gets what the pool leaves
+        budget.pool = std::clamp(rest * 3 / 4, 1, maxPool);
+        budget.opencv = std::max(rest - budget.pool, 1);
+    }
+
+    return budget;
+}
+
+std::string threadBudgetDescribe(const ThreadBudget &budget)
+{
+    std::ostringstream text;
+    text << budget.total << " cores: " << budget.stages << " stage threads, " << budget.pool << " tracker workers, "
+         << budget.opencv << " OpenCV threads, " << budget.codec << " codec threads";
+
+    int used = budget.stages + budget.pool + budget.opencv + budget.codec;
+    if (used > budget.total)
+    {
+        text << " (" << used - budget.total << " more threads than cores)";
+    }
+    return text.str();
+}
@@ -0,0 +1,34 @@
+#ifndef THREAD_BUDGET
+#define THREAD_BUDGET
+
+#include <string>
+
+// Most workers in the tracker pool
+constexpr int sMaxThreads{16};
+// Threads of the pipeline stages: reader, tracker and output
+constexpr int sStageThreads{3};
+
+// Division of the cores between the pipeline and OpenCV's own parallelism
+struct ThreadBudget
+{
+    // Cores to divide
+    int total{1};
+    // Pipeline stage threads, mostly waiting on the decoder, the trackers or the display
+    int stages{sStageThreads};
+    // Workers of the tracker pool, each runs one tracker at a time
+    int pool{1};
+    // Threads of OpenCV's parallel backend (cv::setNumThreads) inside trackers and drawing
+    int opencv{1};
+    // Decoder threads (CAP_PROP_N_THREADS) and encoder stripes (VIDEOWRITER_PROP_NSTRIPES)
+    int codec{1};
+};
+
+// Divide a number of cores, 0 for all of them, between the stages, the pool and OpenCV
+// opencvThreads fixes OpenCV's share, -1 chooses it from the number of cores
+// poolCores is the number of cores the pool is pinned to, it gets no more workers than that; 0 if it floats
+ThreadBudget threadBudgetSplit(int total, int opencvThreads, int poolCores = 0);
+
+// One line description of the split, e.g. for the startup report
+std::string threadBudgetDescribe(const ThreadBudget &budget);
+
+#endif
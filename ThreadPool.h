@@ -1,20 +1,142 @@
+#ifndef THREAD_POOL
+#define THREAD_POOL
+
+#include "Affinity.h"
+#include "AllocTracker.h"
+#include "RingQueue.h"
+
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
-#include <deque>
-#include <functional>
+#include <cstddef>
 #include <map>
+#include <new>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <mutex>
+#include <stop_token>
+
+// Jobs queued before the pool's queue has to grow
+constexpr size_t sPoolQueueSlots{64};
+
+// Callable job of the pool
+// Callables up to sInlineBytes live inside the job, so submitting them does not
+// allocate the way std::function does for captures beyond a pointer or two.
+// Larger callables fall back to the heap.
+class ThreadPoolJob
+{
+private:
+    static constexpr size_t sInlineBytes{64};
+
+    alignas(std::max_align_t) unsigned char mStorage[sInlineBytes];
+    void (*mCall)(void *storage){nullptr};
+    // Move the callable into other storage unless it is null, then destroy it
+    void (*mMoveDestroy)(void *from, void *to){nullptr};
+
+    void take(ThreadPoolJob &other)
+    {
+        if (other.mCall)
+        {
+            other.mMoveDestroy(other.mStorage, mStorage);
+            mCall = other.mCall;
+            mMoveDestroy = other.mMoveDestroy;
+            other.mCall = nullptr;
+            other.mMoveDestroy = nullptr;
+        }
+    }
+
+public:
+    ThreadPoolJob() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, ThreadPoolJob>>>
+    ThreadPoolJob(F &&callable)
+    {
+        using Callable = std::decay_t<F>;
+        if constexpr (sizeof(Callable) <= sInlineBytes && alignof(Callable) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<Callable>)
+        {
+            new (mStorage) Callable(std::forward<F>(callable));
+            mCall = [](void *storage)
+            { (*static_cast<Callable *>(storage))(); };
+            mMoveDestroy = [](void *from, void *to)
+            {
+                Callable *source = static_cast<Callable *>(from);
+                if (to)
+                {
+                    new (to) Callable(std::move(*source));
+                }
+                source->~Callable();
+            };
+        }
+        else
+        {
+            new (mStorage) Callable *(new Callable(std::forward<F>(callable)));
+            mCall = [](void *storage)
+            { (**static_cast<Callable **>(storage))(); };
+            mMoveDestroy = [](void *from, void *to)
+            {
+                Callable *source = *static_cast<Callable **>(from);
+                if (to)
+                {
+                    new (to) Callable *(source);
+                }
+                else
+                {
+                    delete source;
+                }
+            };
+        }
+    }
+    ~ThreadPoolJob() { reset(); }
+
+    ThreadPoolJob(ThreadPoolJob &&other) noexcept { take(other); }
+    ThreadPoolJob &operator=(ThreadPoolJob &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+    ThreadPoolJob(const ThreadPoolJob &) = delete;
+    ThreadPoolJob &operator=(const ThreadPoolJob &) = delete;
+
+    // Destroy the callable, leaving an empty job
+    void reset()
+    {
+        if (mMoveDestroy)
+        {
+            mMoveDestroy(mStorage, nullptr);
+        }
+        mCall = nullptr;
+        mMoveDestroy = nullptr;
+    }
+
+    void operator()() { mCall(mStorage); }
+};
 
 class ThreadPool
 {
 private:
+    // Stops the workers of this pool, when the pipeline stops or the pool is destroyed
+    struct StopLink
+    {
+        std::stop_source source;
+        void operator()() { source.request_stop(); }
+    };
+
     // Worker thread function
     void doWork(std::stop_token st)
     {
+        // Tracker updates run here, charge their allocations to the pool
+        allocStageSet(AllocStage::Pool);
+
         while (!st.stop_requested())
         {
-            std::function<void()> job;
+            ThreadPoolJob job;
             {
                 // Wait for a job to be available or stop requested
                 std::unique_lock lock(mWorkMutex);
@@ -44,10 +166,12 @@ private:
     }
 
     // Members for job queue and worker threads
-    std::deque<std::function<void()>> mWorkQueue;
-    std::vector<std::jthread> mWorkers;
+    RingQueue<ThreadPoolJob> mWorkQueue{sPoolQueueSlots};
     std::mutex mWorkMutex;
     std::condition_variable_any mWorkCv;
+    std::stop_source mStopSource;
+    std::stop_callback<StopLink> mStopLink;
+    std::vector<std::jthread> mWorkers;
 
     // Members for waitAll()
     std::atomic<int> mPendingJobs{0};
@@ -56,15 +180,34 @@ private:
 
 public:
     // Constructor with number of threads and stop token
-    ThreadPool(int n, std::stop_token st)
+    ThreadPool(int n, std::stop_token st) : mStopLink(st, StopLink{mStopSource})
     {
         for (int i = 0; i < n; ++i)
         {
-            mWorkers.emplace_back(&ThreadPool::doWork, this, st);
+            mWorkers.emplace_back(&ThreadPool::doWork, this, mStopSource.get_token());
         }
     }
-    // Default destructor
-    ~ThreadPool() = default;
+    // Stop the workers and wait for their current jobs, queued jobs are dropped
+    ~ThreadPool()
+    {
+        mStopSource.request_stop();
+        mWorkers.clear();
+    }
+
+    // Number of worker threads
+    int size() const { return static_cast<int>(mWorkers.size()); }
+
+    // Pin every worker to the cores, an empty list does nothing
+    // Returns true if successful, false otherwise
+    bool pin(const std::vector<int> &cpus)
+    {
+        bool ok = true;
+        for (auto &worker : mWorkers)
+        {
+            ok = threadPin(worker.native_handle(), cpus) && ok;
+        }
+        return ok;
+    }
     // Delete copy and move constructors and assignment operators
     ThreadPool(const ThreadPool &) = delete;
     ThreadPool &operator=(const ThreadPool &) = delete;
@@ -72,7 +215,7 @@ public:
     ThreadPool &operator=(ThreadPool &&) = delete;
 
     // Submit a new job to the thread pool
-    void submit(std::function<void()> job)
+    void submit(ThreadPoolJob job)
     {
         // Increment pending jobs counter
         mPendingJobs.fetch_add(1);
@@ -84,6 +227,19 @@ public:
         mWorkCv.notify_one();
     }
 
+    // Submit a job that runs before every job already waiting
+    void submitFront(ThreadPoolJob job)
+    {
+        // Increment pending jobs counter
+        mPendingJobs.fetch_add(1);
+        {
+            // Add the job at the head of the queue
+            std::scoped_lock lock(mWorkMutex);
+            mWorkQueue.push_front(std::move(job));
+        }
+        mWorkCv.notify_one();
+    }
+
     // Wait until all submitted jobs are completed or timeout occurs
     // Returns true if all jobs completed, false if timeout occurred
     template <typename Rep, typename Period>
@@ -93,4 +249,6 @@ public:
         return mCompletionCv.wait_for(lock, timeout, [this]
                                       { return mPendingJobs.load() == 0; });
     }
-};
\ No newline at end of file
+};
+
+#endif
\ No newline at end of file
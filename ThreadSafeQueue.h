@@ -1,26 +1,28 @@
 #ifndef THREAD_SAFE_QUEUE
 #define THREAD_SAFE_QUEUE
 
+#include "RingQueue.h"
+
 #include <condition_variable>
-#include <deque>
 #include <mutex>
 #include <optional>
 #include <stop_token>
 
 // Thread-safe queue with a maximum size and generation tracking
+// The ring buffer is sized for the maximum up front, so pushing never allocates
 template <typename T>
 class ThreadSafeQueue
 {
 private:
     std::condition_variable_any mNotFullCv, mNotEmptyCv;
-    std::deque<T> mQueue;
-    std::mutex mMutex;
+    RingQueue<T> mQueue;
+    mutable std::mutex mMutex;
     uint32_t mGeneration{0};
     uint32_t mMaxSize;
 
 public:
     // Constructor with maximum queue size
-    ThreadSafeQueue(uint32_t maxSize) : mMaxSize(maxSize) {}
+    ThreadSafeQueue(uint32_t maxSize) : mQueue(maxSize), mMaxSize(maxSize) {}
     // Delete copy and move constructors and assignment operators
     ThreadSafeQueue(const ThreadSafeQueue &) = delete;
     ThreadSafeQueue operator=(const ThreadSafeQueue &) = delete;
@@ -56,6 +58,27 @@ public:
         mNotEmptyCv.notify_one();
     }
 
+    // Push a new item without waiting, dropping the oldest items if the queue is full
+    // Used for live sources, where consumers should always get the newest item
+    // Returns the number of dropped items
+    size_t pushLatest(T value)
+    {
+        size_t dropped = 0;
+        {
+            std::scoped_lock lock(mMutex);
+            while (!mQueue.empty() && mQueue.size() >= mMaxSize)
+            {
+                mQueue.pop_front();
+                dropped += 1;
+            }
+            mQueue.push_back(std::move(value));
+        }
+
+        // Notify next waiting consumer
+        mNotEmptyCv.notify_one();
+        return dropped;
+    }
+
     // Clear the queue and increment the generation
     void clear()
     {
@@ -109,6 +132,19 @@ public:
         std::scoped_lock lock(mMutex);
         return mQueue.empty();
     }
+
+    // Get the number of queued items
+    size_t size() const
+    {
+        std::scoped_lock lock(mMutex);
+        return mQueue.size();
+    }
+
+    // Get the maximum number of queued items
+    uint32_t capacity() const
+    {
+        return mMaxSize;
+    }
 };
 
 #endif
\ No newline at end of file
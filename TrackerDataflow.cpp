@@ -0,0 +1,353 @@
+#include "TrackerDataflow.h"
+#include "AllocTracker.h"
+#include "Highlight.h"
+#include "LumaFrame.h"
+#include "SearchWindow.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <tuple>
+
+#include "opencv2/imgproc.hpp"
+
+TrackerDataflow::TrackerDataflow(std::shared_ptr<ControlNode> controlNode,
+                                 std::shared_ptr<ThreadSafeQueue<Frame>> inputQueue,
+                                 std::shared_ptr<ThreadSafeQueue<Frame>> outputQueue,
+                                 std::shared_ptr<CropExporter> cropExporter,
+                                 std::shared_ptr<ResultsWriter> resultsWriter)
+    : mControlNode(controlNode),
+      mInputQueue(inputQueue),
+      mOutputQueue(outputQueue),
+      mCropExporter(cropExporter),
+      mResultsWriter(resultsWriter),
+      mReleaser([this](std::stop_token st)
+                { releaseFrames(st); })
+{
+    // Every slot in the window, and the one being admitted, is kept once finished
+    mSpareSlots.reserve(sTrackerWindow + 1);
+
+    // The releaser hands frames on from the pool's results, keep it with the tracker stage
+    std::vector<int> cpus = mControlNode->affinityGet().tracker;
+    if (!threadPin(mReleaser.native_handle(), cpus))
+    {
+        std::cerr << "Warning: Could not pin the tracker releaser to cores " << cpuListFormat(cpus) << std::endl;
+    }
+}
+
+TrackerDataflow::~TrackerDataflow()
+{
+    std::scoped_lock lock(mMutex);
+
+    // Report the trackers that had to skip updates to stay within the time budget
+    for (const auto &[tracker, lane] : mLanes)
+    {
+        if (lane.deferrals > 0)
+        {
+            std::cout << "Tracker " << lane.id << ": " << lane.deferrals << " updates deferred" << std::endl;
+        }
+    }
+}
+
+void TrackerDataflow::admit(Frame &&frame, std::stop_token st)
+{
+    // Reuse a finished slot when there is one
+    std::unique_ptr<Slot> slot;
+    {
+        std::scoped_lock lock(mMutex);
+        if (!mSpareSlots.empty())
+        {
+            slot = std::move(mSpareSlots.back());
+            mSpareSlots.pop_back();
+        }
+    }
+    if (!slot)
+    {
+        slot = std::make_unique<Slot>();
+    }
+
+    // Plan in frame order, so every lane sees its frames in order
+    mControlNode->trackersPlan(frame, slot->steps);
+    slot->frame = std::move(frame);
+    slot->frame.results.assign(slot->steps.size(), TrackerResult{});
+    slot->pending.store(slot->steps.size());
+
+    // The time budget of a frame starts when it enters the stage
+    double budgetMs = mControlNode->trackingBudgetGet();
+    slot->admitted = std::chrono::steady_clock::now();
+    slot->trackingNs.store(0);
+    slot->deadline = budgetMs > 0.0 ? slot->admitted +
+                                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                              std::chrono::duration<double, std::milli>(budgetMs))
+                                    : std::chrono::steady_clock::time_point::max();
+
+    mIdleLanes.clear();
+    mDeferredLanes.clear();
+    {
+        std::unique_lock lock(mMutex);
+        if (!mWindowCv.wait(lock, st, [this]
+                            { return mWindow.size() < sTrackerWindow; }))
+        {
+            // Woken by stop token
+            return;
+        }
+        Slot *admitted = slot.get();
+        mWindow.push_back(std::move(slot));
+
+        // Queue the frame on the lane of each of its trackers
+        for (size_t i = 0; i < admitted->steps.size(); ++i)
+        {
+            Lane &lane = mLanes[admitted->steps[i].tracker];
+            lane.id = admitted->steps[i].id;
+            lane.work.push_back({admitted, i});
+            if (!lane.running)
+            {
+                lane.running = true;
+                (lane.deferred ? mDeferredLanes : mIdleLanes).push_back(admitted->steps[i].tracker);
+            }
+        }
+    }
+
+    // A frame without trackers is finished right away
+    mWindowCv.notify_all();
+
+    // Start the lanes that were idle, running lanes pick the frame up themselves
+    // Lanes deferred on the previous frame jump the queue, so every tracker gets its turn
+    // Frames without lanes to start leave the pool alone, it is only created for trackers
+    if (mDeferredLanes.empty() && mIdleLanes.empty())
+    {
+        return;
+    }
+    ThreadPool &pool = mControlNode->threadPoolGet();
+    for (ObjectTracker *tracker : mDeferredLanes)
+    {
+        pool.submitFront([self = shared_from_this(), tracker]
+                         { self->laneRun(tracker); });
+    }
+    for (ObjectTracker *tracker : mIdleLanes)
+    {
+        pool.submit([self = shared_from_this(), tracker]
+                    { self->laneRun(tracker); });
+    }
+}
+
+void TrackerDataflow::laneRun(ObjectTracker *tracker)
+{
+    while (true)
+    {
+        Slot *slot = nullptr;
+        size_t stepIndex = 0;
+        TrackerAction action = TrackerAction::Reuse;
+        int deferrals = 0;
+        {
+            std::scoped_lock lock(mMutex);
+            Lane &lane = mLanes[tracker];
+            if (lane.work.empty())
+            {
+                lane.running = false;
+                return;
+            }
+            std::tie(slot, stepIndex) = lane.work.front();
+            lane.work.pop_front();
+
+            // Frames of an old generation are dropped after tracking, and their boxes
+            // must not move trackers that were rewound, only count them down
+            // An update starting after the frame's deadline is skipped, the tracker keeps its box
+            action = slot->steps[stepIndex].action;
+            if (slot->frame.generation != mControlNode->generationGet())
+            {
+                action = TrackerAction::Reuse;
+            }
+            else if (action == TrackerAction::Update)
+            {
+                lane.deferred = std::chrono::steady_clock::now() > slot->deadline;
+                if (lane.deferred)
+                {
+                    action = TrackerAction::Reuse;
+                    lane.deferrals += 1;
+                }
+            }
+            deferrals = lane.deferrals;
+        }
+
+        // Only this lane touches the tracker, and trackers only read the image
+        // Each tracker searches its own window of the frame, see SearchWindow.h
+        const TrackerStep &step = slot->steps[stepIndex];
+        const cv::Mat &image = frameTrackingImage(slot->frame);
+        if (action == TrackerAction::Update)
+        {
+            // Nothing moved around the object since its last update, keep the box
+            // Skipped updates keep the old reference so slow drift still adds up
+            double difference = tracker->region.difference(image, tracker->box);
+            if (difference >= 0.0 && difference < sStaticMeanDiff)
+            {
+                action = TrackerAction::Reuse;
+            }
+            else
+            {
+                tracker->region.keep();
+            }
+        }
+        else if (action == TrackerAction::Lose)
+        {
+            // The scene may cut back to the object, its region then looks as before the cut
+            double difference = tracker->region.difference(image, tracker->box);
+            if (difference >= 0.0 && difference < sReturnMeanDiff)
+            {
+                mControlNode->trackerFound(*tracker, step.id, slot->frame.idx);
+                tracker->region.keep();
+                action = TrackerAction::Update;
+            }
+        }
+
+        if (action == TrackerAction::Update)
+        {
+            auto updateStart = std::chrono::steady_clock::now();
+
+            // A KCF model only fits the patch size it was trained with, so after a change
+            // of the quality level the tracker starts again at its box with the new size
+            int patchArea = mControlNode->trackerPatchAreaGet();
+            cv::Rect box = tracker->box & cv::Rect(0, 0, image.cols, image.rows);
+            if (tracker->patchArea != patchArea && !box.empty())
+            {
+                tracker->tracker = cv::TrackerKCF::create(ControlNode::trackerParams(image.channels(), patchArea));
+                tracker->patchArea = patchArea;
+                trackerInit(*tracker, image, box, tracker->mode);
+                tracker->active = true;
+            }
+            else
+            {
+                tracker->active = trackerUpdate(*tracker, image);
+            }
+            std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - updateStart;
+            slot->trackingNs.fetch_add(elapsed.count(), std::memory_order_relaxed);
+        }
+        else if (action == TrackerAction::Lose)
+        {
+            tracker->active = false;
+        }
+        slot->frame.results[stepIndex] = {step.id, tracker->box, tracker->active, deferrals};
+
+        // Count down under the lock so the releaser cannot miss the last tracker
+        bool finished = false;
+        {
+            std::scoped_lock lock(mMutex);
+            finished = slot->pending.fetch_sub(1) == 1;
+        }
+        if (finished)
+        {
+            mWindowCv.notify_all();
+        }
+    }
+}
+
+void TrackerDataflow::releaseFrames(std::stop_token st)
+{
+    allocStageSet(AllocStage::Tracker);
+
+    while (true)
+    {
+        std::unique_ptr<Slot> slot;
+        {
+            std::unique_lock lock(mMutex);
+            if (!mWindowCv.wait(lock, st, [this]
+                                { return !mWindow.empty() && mWindow.front()->pending.load() == 0; }))
+            {
+                // Woken by stop token
+                return;
+            }
+            slot = std::move(mWindow.front());
+            mWindow.pop_front();
+        }
+
+        // Room for the next frame
+        mWindowCv.notify_all();
+
+        finishFrame(*slot, st);
+
+        // The frame has moved on, keep the slot for a later frame
+        slot->frame = Frame();
+        std::scoped_lock lock(mMutex);
+        mSpareSlots.push_back(std::move(slot));
+    }
+}
+
+void TrackerDataflow::finishFrame(Slot &slot, std::stop_token st)
+{
+    Frame &frame = slot.frame;
+
+    // Frames of an old generation would be dropped by the output, skip the work
+    if (frame.generation != mControlNode->generationGet())
+    {
+        return;
+    }
+
+    if (frameEmpty(frame))
+    {
+        // A save ends at the end of the video, finish the crop videos
+        if (mCropExporter && frame.idx == -1)
+        {
+            mCropExporter->close();
+        }
+    }
+    else
+    {
+        // Hand the boxes to the results file, written in the background
+        if (mResultsWriter)
+        {
+            mResultsWriter->record(frame.idx, frame.results);
+        }
+
+        // Frames tracked on luma only get a BGR image when something will use it
+        if (mControlNode->renderNeeded() || mControlNode->isSaving())
+        {
+            frameRender(frame);
+        }
+
+        // Crops are cut from the frame as decoded, before the highlights are drawn
+        if (mCropExporter && mControlNode->isSaving())
+        {
+            mCropExporter->exportFrame(frame.image, frame.results, mControlNode->threadPoolGet());
+        }
+
+        // Highlight the active boxes
+        frameHighlight(frame);
+
+        // Let the quality-of-service controller react to the stage's own work
+        // Files are read ahead into a full queue, so their latency starts after the queue wait
+        // Live queues hold a single replaceable frame, there it starts at the capture
+        auto now = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::milli> latency = now - (mControlNode->capIsLive() ? frame.readTime : slot.admitted);
+
+        // Lanes run side by side on the pool, the load compares the tracking time per worker with the frame period
+        // Frames without updates never touch the pool, so it is not created for them
+        double fps = mControlNode->capFpsGet();
+        int64_t trackingNs = slot.trackingNs.load();
+        double load = 0.0;
+        if (fps > 0.0 && trackingNs > 0)
+        {
+            double trackingMs = trackingNs / 1e6 / std::max(mControlNode->threadPoolGet().size(), 1);
+            load = trackingMs * fps / 1000.0;
+        }
+        mControlNode->qosUpdate(latency.count(), load);
+
+        // Downscale the display copy here so the UI thread only has to show it
+        double scale = mControlNode->previewScaleGet();
+        if (scale < 1.0 && !frame.image.empty())
+        {
+            cv::resize(frame.image, frame.preview, cv::Size(), scale, scale, cv::INTER_LINEAR);
+        }
+
+        // Rendering, highlighting and the preview may have added buffers
+        frameLeaseUpdate(frame);
+    }
+
+    // Live sources replace a frame the output has not shown yet
+    if (mControlNode->capIsLive())
+    {
+        mOutputQueue->pushLatest(std::move(frame));
+        return;
+    }
+
+    mOutputQueue->push(std::move(frame), st);
+}
@@ -0,0 +1,103 @@
+#ifndef TRACKER_DATAFLOW
+#define TRACKER_DATAFLOW
+
+#include "ControlNode.h"
+#include "CropExporter.h"
+#include "DataStructs.h"
+#include "ResultsWriter.h"
+#include "RingQueue.h"
+#include "ThreadSafeQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Frames inside the tracker stage at once
+constexpr size_t sTrackerWindow{4};
+
+// Per-object dataflow for the tracker stage
+// Every tracker runs through the frames of the window in order on its own lane,
+// waiting only for its own previous update instead of for the slowest tracker.
+// A frame is finished and passed on, in order, once all of its trackers are done.
+// Slots, lanes and their queues are reused, so a steady stream of frames
+// is tracked without heap allocations of the stage itself.
+class TrackerDataflow : public std::enable_shared_from_this<TrackerDataflow>
+{
+private:
+    // A frame in the window and the trackers still working on it
+    struct Slot
+    {
+        Frame frame;
+        std::vector<TrackerStep> steps;
+        std::atomic<size_t> pending{0};
+        // Updates that have not started by then are deferred
+        std::chrono::steady_clock::time_point deadline;
+        // When the frame entered the stage, and the time its trackers spent updating
+        std::chrono::steady_clock::time_point admitted;
+        std::atomic<int64_t> trackingNs{0};
+    };
+
+    // Frames a tracker still has to process, in order
+    // Slots stay in the window until every lane is done with them
+    struct Lane
+    {
+        RingQueue<std::pair<Slot *, size_t>> work{sTrackerWindow};
+        bool running{false};
+        // Tracker id, and updates skipped for the time budget
+        int id{0};
+        int deferrals{0};
+        // The last update was deferred, the lane goes first on the next frame
+        bool deferred{false};
+    };
+
+    std::shared_ptr<ControlNode> mControlNode;
+    std::shared_ptr<ThreadSafeQueue<Frame>> mInputQueue;
+    std::shared_ptr<ThreadSafeQueue<Frame>> mOutputQueue;
+    std::shared_ptr<CropExporter> mCropExporter;
+    std::shared_ptr<ResultsWriter> mResultsWriter;
+
+    std::mutex mMutex;
+    std::condition_variable_any mWindowCv;
+    RingQueue<std::unique_ptr<Slot>> mWindow{sTrackerWindow};
+    // Finished slots, reused with the capacity of their steps
+    std::vector<std::unique_ptr<Slot>> mSpareSlots;
+    std::unordered_map<ObjectTracker *, Lane> mLanes;
+    // Lanes to start for the frame being admitted, only used by admit
+    std::vector<ObjectTracker *> mIdleLanes;
+    std::vector<ObjectTracker *> mDeferredLanes;
+    std::jthread mReleaser;
+
+    // Run the work of a lane until it runs dry
+    void laneRun(ObjectTracker *tracker);
+    // Pass finished frames on in order until stopped
+    void releaseFrames(std::stop_token st);
+    // Draw, export and downscale a finished frame, then pass it to the output queue
+    void finishFrame(Slot &slot, std::stop_token st);
+
+public:
+    TrackerDataflow(std::shared_ptr<ControlNode> controlNode,
+                    std::shared_ptr<ThreadSafeQueue<Frame>> inputQueue,
+                    std::shared_ptr<ThreadSafeQueue<Frame>> outputQueue,
+                    std::shared_ptr<CropExporter> cropExporter,
+                    std::shared_ptr<ResultsWriter> resultsWriter);
+    // Reports how often each tracker's update was deferred
+    ~TrackerDataflow();
+
+    // Delete copy and move constructors and assignment operators
+    TrackerDataflow(const TrackerDataflow &) = delete;
+    TrackerDataflow &operator=(const TrackerDataflow &) = delete;
+    TrackerDataflow(TrackerDataflow &&) = delete;
+    TrackerDataflow &operator=(TrackerDataflow &&) = delete;
+
+    // Add a frame to the window and hand it to the lanes of its trackers
+    // Waits while the window is full, returns without adding it if stopped
+    void admit(Frame &&frame, std::stop_token st);
+};
+
+#endif
@@ -1,7 +1,5 @@
 #include "TrackerNode.h"
 
-#include "opencv2/imgproc.hpp"
-
 std::optional<Frame> TrackerNode::getFrame(std::stop_token st)
 {
     return mInputQueue->waitAndPop(st);
@@ -9,15 +7,11 @@ std::optional<Frame> TrackerNode::getFrame(std::stop_token st)
 
 void TrackerNode::updateFrame(Frame &frame)
 {
-    if (frame.image.empty())
-    {
-        return;
-    }
-
-    mControlNode->trackersUpdateAndDraw(frame);
+    // Tracking happens on the lanes of the dataflow, after the frame is passed on
 }
 
-void TrackerNode::passFrame(const Frame &frame, std::stop_token st)
+void TrackerNode::passFrame(Frame &&frame, std::stop_token st)
 {
-    mOutputQueue->push(frame, st);
+    // The dataflow passes the frame on to the output once every tracker is done with it
+    mDataflow->admit(std::move(frame), st);
 }
\ No newline at end of file
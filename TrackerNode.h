@@ -2,24 +2,28 @@
 #define TRACKER_NODE
 
 #include "ControlNode.h"
+#include "CropExporter.h"
 #include "DataStructs.h"
 #include "Node.h"
+#include "ResultsWriter.h"
 #include "ThreadSafeQueue.h"
+#include "TrackerDataflow.h"
 
 class TrackerNode
 {
 private:
-    std::shared_ptr<ControlNode> mControlNode;
     std::shared_ptr<ThreadSafeQueue<Frame>> mInputQueue;
-    std::shared_ptr<ThreadSafeQueue<Frame>> mOutputQueue;
+    // Tracks the frames and passes them on to the output queue in order
+    std::shared_ptr<TrackerDataflow> mDataflow;
 
 public:
     TrackerNode(std::shared_ptr<ControlNode> controlNode,
                 std::shared_ptr<ThreadSafeQueue<Frame>> inputQueue,
-                std::shared_ptr<ThreadSafeQueue<Frame>> outputQueue)
-        : mControlNode(controlNode),
-          mInputQueue(inputQueue),
-          mOutputQueue(outputQueue) {}
+                std::shared_ptr<ThreadSafeQueue<Frame>> outputQueue,
+                std::shared_ptr<CropExporter> cropExporter = nullptr,
+                std::shared_ptr<ResultsWriter> resultsWriter = nullptr)
+        : mInputQueue(inputQueue),
+          mDataflow(std::make_shared<TrackerDataflow>(controlNode, inputQueue, outputQueue, cropExporter, resultsWriter)) {}
     ~TrackerNode() = default;
 
     TrackerNode(const TrackerNode &) = delete;
@@ -31,7 +35,7 @@ public:
     // Node concept methods
     std::optional<Frame> getFrame(std::stop_token st);
     void updateFrame(Frame &f);
-    void passFrame(const Frame &f, std::stop_token st);
+    void passFrame(Frame &&f, std::stop_token st);
 };
 
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "VideoProcessor.h"
 
 #include <algorithm>
+#include <future>
 #include <iostream>
 
 using std::cout;
@@ -16,24 +17,43 @@ void VideoProcessor::displayInfo()
         return;
     }
 
-    // Retrieve video properties
-    int fps = static_cast<int>(mControlNode->capGet(cv::CAP_PROP_FPS));
-    int frames = static_cast<int>(mControlNode->capGet(cv::CAP_PROP_FRAME_COUNT));
-    int width = static_cast<int>(mControlNode->capGet(cv::CAP_PROP_FRAME_WIDTH));
-    int height = static_cast<int>(mControlNode->capGet(cv::CAP_PROP_FRAME_HEIGHT));
+    // Retrieve video properties, under a single lock of the capture
+    CaptureInfo info = mControlNode->capInfo();
+    int fps = static_cast<int>(info.fps);
 
     // Display video information
     cout << "FPS: " << fps << endl;
-    cout << "Frame count: " << frames << endl;
-    cout << "Duration: " << frames / fps << "s" << endl;
-    cout << "Resolution: " << width << " x " << height << endl;
+    cout << "Frame count: " << info.frames << endl;
+    if (fps > 0 && info.frames > 0)
+    {
+        cout << "Duration: " << info.frames / fps << "s" << endl;
+    }
+    cout << "Resolution: " << info.size.width << " x " << info.size.height << endl;
 }
 
 // Load a video from the specified path
+// The container is probed on another thread while the window comes up,
+// and the first frames are decoded in the background from then on
 bool VideoProcessor::loadVideo(const std::string &videoPath)
 {
-    // Open the video file using the control node
-    return mControlNode->capOpen(videoPath);
+    std::future<bool> opened = std::async(std::launch::async, [this, &videoPath]
+                                          {
+                                              // Open the video file using the control node
+                                              if (!mControlNode->capOpen(videoPath))
+                                              {
+                                                  return false;
+                                              }
+                                              mControlNode->capPrefetch(sPrefetchFrames);
+                                              return true; });
+
+    windowCreate();
+    return opened.get();
+}
+
+// Create the main window ahead of the first frame
+void VideoProcessor::windowCreate()
+{
+    cv::namedWindow(sMainTitle, cv::WINDOW_AUTOSIZE);
 }
 
 // Play the loaded video, allowing for pausing and rewinding
@@ -53,8 +73,9 @@ void VideoProcessor::playVideo()
         // Display the frame
         cv::imshow(sMainTitle, frame);
 
-        // Handle key presses
+        // Handle key presses, this also paints the frame
         int key = cv::waitKey(1);
+        mControlNode->firstFrameShown();
         if (key == 'q')
         {
             break;
@@ -30,6 +30,9 @@ public:
     void rewindVideo(int time);
 
 protected:
+    // Create the playback window, called while the video is being opened
+    virtual void windowCreate();
+
     // Control node for managing video capture and processing
     // across multiple threads
     std::shared_ptr<ControlNode> mControlNode;
@@ -0,0 +1,530 @@
+#include "AllocTracker.h"
+#include "ControlNode.h"
+#include "DataStructs.h"
+#include "NodeRunner.h"
+#include "ObjectHighlighter.h"
+#include "ReaderNode.h"
+#include "SearchWindow.h"
+#include "ThreadBudget.h"
+#include "ThreadSafeQueue.h"
+#include "TrackerNode.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+#include "opencv2/imgproc.hpp"
+#include "opencv2/tracking.hpp"
+#include "opencv2/videoio.hpp"
+
+using std::cout;
+using std::endl;
+
+// Command line argument keys
+const char *keys =
+    "{help h usage ?  |                   | print this message                        }"
+    "{resolutions r   | 640x360,1280x720  | comma separated list of WxH resolutions   }"
+    "{objects n       | 1,8               | comma separated list of object counts     }"
+    "{sizes s         | 48                | comma separated list of object sizes (px) }"
+    "{speeds v        | 2,8               | comma separated list of speeds (px/frame) }"
+    "{frames          | 150               | frames per generated video                }"
+    "{seed            | 42                | random seed for video generation          }"
+    "{threads         | 0                 | cores to divide, 0 for all                }"
+    "{opencv-threads  | -1                | comma separated list of OpenCV shares of the cores to sweep, -1 for automatic }"
+    "{search-window   | off               | what trackers search in: off, view or gather }"
+    "{workdir         | /tmp              | directory for generated videos            }"
+    "{csv             |                   | optional CSV file for the results         }";
+
+// One generated test video
+struct Scenario
+{
+    cv::Size resolution;
+    int objects;
+    int objectSize;
+    double speed;
+    int frames;
+};
+
+// Measurements for a single scenario run
+struct ScenarioResult
+{
+    int frames{0};
+    double seconds{0.0};
+    double fps{0.0};
+    double latencyP50{0.0};
+    double latencyP95{0.0};
+    double latencyP99{0.0};
+    double meanIoU{0.0};
+    double trackedRatio{0.0};
+    // Steady-state heap and Mat allocations of all stages per frame, with ENABLE_ALLOC_TRACKING
+    double allocationsPerFrame{0.0};
+    double allocatedBytesPerFrame{0.0};
+};
+
+// Ground truth boxes indexed by [frame][object]
+using GroundTruth = std::vector<std::vector<cv::Rect>>;
+
+// Samples collected by the sink stage of the pipeline
+struct BenchSamples
+{
+    std::vector<double> latenciesMs;
+    double iouSum{0.0};
+    int iouCount{0};
+    int trackedCount{0};
+    std::chrono::steady_clock::time_point endTime;
+};
+
+// Headless final stage that scores each frame against the ground truth
+class BenchSinkNode
+{
+private:
+    std::shared_ptr<ControlNode> mControlNode;
+    std::shared_ptr<ThreadSafeQueue<Frame>> mInputQueue;
+    std::shared_ptr<BenchSamples> mSamples;
+    const GroundTruth *mGroundTruth;
+
+public:
+    BenchSinkNode(std::shared_ptr<ControlNode> controlNode,
+                  std::shared_ptr<ThreadSafeQueue<Frame>> inputQueue,
+                  std::shared_ptr<BenchSamples> samples,
+                  const GroundTruth *groundTruth)
+        : mControlNode(controlNode),
+          mInputQueue(inputQueue),
+          mSamples(samples),
+          mGroundTruth(groundTruth) {}
+
+    // Node concept methods
+    std::optional<Frame> getFrame(std::stop_token st)
+    {
+        return mInputQueue->waitAndPop(st);
+    }
+
+    void updateFrame(Frame &frame)
+    {
+    }
+
+    void passFrame(Frame &&frame, std::stop_token st)
+    {
+        // Check for end of video signal
+        if (frame.idx == -1)
+        {
+            mSamples->endTime = std::chrono::steady_clock::now();
+            mControlNode->stopSourceGet().request_stop();
+            mControlNode->capRelease();
+            return;
+        }
+
+        std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - frame.readTime;
+        mSamples->latenciesMs.push_back(latency.count());
+
+        // Score every tracker against the object it was initialized on
+        const auto &truth = (*mGroundTruth)[frame.idx];
+        for (const auto &result : frame.results)
+        {
+            double iou = 0.0;
+            if (result.active)
+            {
+                const cv::Rect &expected = truth[result.id];
+                double intersection = (result.box & expected).area();
+                double unionArea = result.box.area() + expected.area() - intersection;
+                iou = unionArea > 0.0 ? intersection / unionArea : 0.0;
+            }
+
+            mSamples->iouSum += iou;
+            mSamples->iouCount += 1;
+            mSamples->trackedCount += iou >= 0.5 ? 1 : 0;
+        }
+
+        // The reader decodes into the buffers of scored frames
+        mControlNode->frameRecycle(std::move(frame));
+    }
+};
+
+// Split a comma separated list into its items
+static std::vector<std::string> splitList(const std::string &list)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// Parse a "WxH" resolution string, returns an empty size on failure
+static cv::Size parseResolution(const std::string &text)
+{
+    int width = 0;
+    int height = 0;
+    char separator = 0;
+    std::stringstream ss(text);
+    if (!(ss >> width >> separator >> height) || separator != 'x')
+    {
+        return cv::Size();
+    }
+    return cv::Size(width, height);
+}
+
+// Parse a whole string as a number, returns false if anything else is left over
+template <typename T>
+static bool parseNumber(const std::string &text, T &value)
+{
+    std::stringstream ss(text);
+    return static_cast<bool>(ss >> value) && (ss >> std::ws).eof();
+}
+
+// Parse every item of a comma separated list of numbers
+// Returns false and reports the option if an item is not a number
+template <typename T>
+static bool parseNumberList(const cv::CommandLineParser &parser, const std::string &option, std::vector<T> &values)
+{
+    values.clear();
+    for (const auto &item : splitList(parser.get<std::string>(option)))
+    {
+        T value{};
+        if (!parseNumber(item, value))
+        {
+            std::cerr << "Error: Invalid number in --" << option << ": " << item << endl;
+            return false;
+        }
+        values.push_back(value);
+    }
+    return true;
+}
+
+// Build the list of scenarios from the command line sweeps
+// Returns false if a sweep holds something that is not a number
+static bool buildScenarios(const cv::CommandLineParser &parser, std::vector<Scenario> &scenarios)
+{
+    int frames = parser.get<int>("frames");
+    std::vector<int> objectCounts;
+    std::vector<int> sizes;
+    std::vector<double> speeds;
+    if (!parseNumberList(parser, "objects", objectCounts) || !parseNumberList(parser, "sizes", sizes) ||
+        !parseNumberList(parser, "speeds", speeds))
+    {
+        return false;
+    }
+
+    for (const auto &res : splitList(parser.get<std::string>("resolutions")))
+    {
+        cv::Size resolution = parseResolution(res);
+        if (resolution.empty())
+        {
+            std::cerr << "Skipping invalid resolution: " << res << endl;
+            continue;
+        }
+
+        for (int objects : objectCounts)
+        {
+            for (int size : sizes)
+            {
+                for (double speed : speeds)
+                {
+                    scenarios.push_back({resolution, objects, size, speed, frames});
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// Generate a video of textured boxes bouncing over a static textured background
+// The box positions of every frame are written to groundTruth
+static bool generateVideo(const Scenario &scenario, const std::string &path, int seed, GroundTruth &groundTruth)
+{
+    cv::VideoWriter writer(path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30.0, scenario.resolution);
+    if (!writer.isOpened())
+    {
+        return false;
+    }
+
+    cv::RNG rng(seed);
+
+    // Low contrast background so the objects are distinguishable
+    cv::Mat background(scenario.resolution, CV_8UC3);
+    rng.fill(background, cv::RNG::UNIFORM, cv::Scalar::all(60), cv::Scalar::all(120));
+    cv::GaussianBlur(background, background, cv::Size(7, 7), 0);
+
+    // Each object gets its own high contrast texture, position and velocity
+    int size = std::min({scenario.objectSize, scenario.resolution.width, scenario.resolution.height});
+    std::vector<cv::Mat> textures;
+    std::vector<cv::Point2d> positions;
+    std::vector<cv::Point2d> velocities;
+    for (int i = 0; i < scenario.objects; ++i)
+    {
+        cv::Mat texture(size, size, CV_8UC3);
+        rng.fill(texture, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+        cv::GaussianBlur(texture, texture, cv::Size(3, 3), 0);
+        textures.push_back(texture);
+
+        positions.emplace_back(rng.uniform(0.0, double(scenario.resolution.width - size)),
+                               rng.uniform(0.0, double(scenario.resolution.height - size)));
+        double angle = rng.uniform(0.0, 2.0 * CV_PI);
+        velocities.emplace_back(scenario.speed * std::cos(angle), scenario.speed * std::sin(angle));
+    }
+
+    groundTruth.assign(scenario.frames, std::vector<cv::Rect>());
+    cv::Mat image;
+    for (int f = 0; f < scenario.frames; ++f)
+    {
+        background.copyTo(image);
+
+        for (int i = 0; i < scenario.objects; ++i)
+        {
+            cv::Rect box(cv::Point(cvRound(positions[i].x), cvRound(positions[i].y)), cv::Size(size, size));
+            textures[i].copyTo(image(box));
+            groundTruth[f].push_back(box);
+
+            // Move the object and bounce off the frame edges
+            positions[i] += velocities[i];
+            if (positions[i].x < 0 || positions[i].x > scenario.resolution.width - size)
+            {
+                velocities[i].x = -velocities[i].x;
+                positions[i].x = std::clamp(positions[i].x, 0.0, double(scenario.resolution.width - size));
+            }
+            if (positions[i].y < 0 || positions[i].y > scenario.resolution.height - size)
+            {
+                velocities[i].y = -velocities[i].y;
+                positions[i].y = std::clamp(positions[i].y, 0.0, double(scenario.resolution.height - size));
+            }
+        }
+
+        writer.write(image);
+    }
+
+    return true;
+}
+
+// Return the given percentile (0-100) of the samples
+static double percentile(std::vector<double> samples, double pct)
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+
+    size_t rank = static_cast<size_t>(pct / 100.0 * (samples.size() - 1) + 0.5);
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
+
+// Run the reader and tracker stages headless over the generated video with the given division of the cores
+static ScenarioResult runPipeline(const std::string &path, const GroundTruth &groundTruth, const ThreadBudget &budget,
+                                  SearchWindowMode searchWindowMode)
+{
+    ScenarioResult result;
+
+    auto controlNode = std::make_shared<ControlNode>(cv::VideoCapture());
+    controlNode->threadBudgetSet(budget);
+    controlNode->searchWindowModeSet(searchWindowMode);
+    if (!controlNode->capOpen(path))
+    {
+        std::cerr << "Error: Could not open generated video: " << path << endl;
+        return result;
+    }
+
+    // Initialize one tracker per object on the first frame
+    cv::Mat first;
+    if (!controlNode->capRead(first))
+    {
+        return result;
+    }
+
+    controlNode->trackersCreateAndRewind(first, groundTruth[0], 0);
+
+    auto readerTrackerQueue = std::make_shared<ThreadSafeQueue<Frame>>(sProcessorQueueSize);
+    auto trackerSinkQueue = std::make_shared<ThreadSafeQueue<Frame>>(sWriterQueueSize);
+    auto samples = std::make_shared<BenchSamples>();
+    samples->latenciesMs.reserve(groundTruth.size());
+    auto frameBudget = std::make_shared<FrameBudget>(sFrameBudgetMB * 1024 * 1024);
+    controlNode->frameSpareLimitSet(frameBudget->capacityGet() / sSpareBudgetDivisor);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        auto readerNode = NodeRunner<ReaderNode>(ReaderNode(controlNode, readerTrackerQueue, frameBudget),
+                                                 controlNode, AllocStage::Reader);
+        auto trackerNode = NodeRunner<TrackerNode>(TrackerNode(controlNode, readerTrackerQueue, trackerSinkQueue),
+                                                   controlNode, AllocStage::Tracker);
+        auto sinkNode = NodeRunner<BenchSinkNode>(BenchSinkNode(controlNode, trackerSinkQueue, samples, &groundTruth),
+                                                  controlNode, AllocStage::Output);
+        allocTrackingStart();
+
+        readerNode.start();
+        trackerNode.start();
+        sinkNode.start();
+
+        // Wait for the sink to see the end of the video
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool done = false;
+
+        std::stop_callback callback(controlNode->stopSourceGet().get_token(), [&]()
+                                    {
+                                        {
+                                            std::scoped_lock lock(mtx);
+                                            done = true;
+                                        }
+                                        cv.notify_all(); });
+
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&done]
+                { return done; });
+    }
+
+    std::chrono::duration<double> elapsed = samples->endTime - start;
+    result.frames = static_cast<int>(samples->latenciesMs.size());
+    result.seconds = elapsed.count();
+    result.fps = result.seconds > 0.0 ? result.frames / result.seconds : 0.0;
+    result.latencyP50 = percentile(samples->latenciesMs, 50);
+    result.latencyP95 = percentile(samples->latenciesMs, 95);
+    result.latencyP99 = percentile(samples->latenciesMs, 99);
+    if (samples->iouCount > 0)
+    {
+        result.meanIoU = samples->iouSum / samples->iouCount;
+        result.trackedRatio = static_cast<double>(samples->trackedCount) / samples->iouCount;
+    }
+
+    // Pool allocations are per tracked frame, so the stages add up to the cost of a frame
+    for (AllocStage stage : {AllocStage::Reader, AllocStage::Tracker, AllocStage::Pool, AllocStage::Output})
+    {
+        AllocRate rate = allocRateGet(stage);
+        result.allocationsPerFrame += rate.allocations + rate.matAllocations;
+        result.allocatedBytesPerFrame += rate.bytes + rate.matBytes;
+    }
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse command line arguments
+    cv::CommandLineParser parser(argc, argv, keys);
+    parser.about("Object Highlighter Benchmark v1.0");
+
+    if (parser.has("help"))
+    {
+        parser.printMessage();
+        return 0;
+    }
+
+    std::vector<Scenario> scenarios;
+    std::vector<int> opencvThreadCounts;
+    if (!buildScenarios(parser, scenarios) || !parseNumberList(parser, "opencv-threads", opencvThreadCounts))
+    {
+        parser.printMessage();
+        return 1;
+    }
+    int seed = parser.get<int>("seed");
+    std::string workdir = parser.get<std::string>("workdir");
+    std::string csvPath = parser.get<std::string>("csv");
+
+    // Divisions of the cores to compare on every scenario
+    int threads = std::max(parser.get<int>("threads"), 0);
+    std::vector<ThreadBudget> budgets;
+    for (int opencvThreads : opencvThreadCounts)
+    {
+        budgets.push_back(threadBudgetSplit(threads, opencvThreads));
+    }
+
+    // Compare search window modes by running the benchmark once per mode
+    std::string searchWindowText = parser.get<std::string>("search-window");
+
+    // Check if the parser is correctly initialized
+    // Needs to happen after get calls as they set the error flag
+    if (!parser.check())
+    {
+        parser.printErrors();
+        return 1;
+    }
+
+    SearchWindowMode searchWindowMode = SearchWindowMode::Off;
+    if (!searchWindowModeParse(searchWindowText, searchWindowMode))
+    {
+        std::cerr << "Error: Unknown search window mode: " << searchWindowText << endl;
+        return 1;
+    }
+    cout << "Search window: " << searchWindowText << endl;
+
+    std::ofstream csv;
+    if (!csvPath.empty())
+    {
+        csv.open(csvPath);
+        csv << "width,height,objects,size,speed,cores,pool,opencv,codec,frames,seconds,fps,p50_ms,p95_ms,p99_ms,mean_iou,tracked_ratio";
+        if (sAllocTracking)
+        {
+            csv << ",allocs_per_frame,alloc_bytes_per_frame";
+        }
+        csv << endl;
+    }
+
+    cout << std::left << std::setw(11) << "resolution" << std::setw(9) << "objects" << std::setw(6) << "size"
+         << std::setw(7) << "speed" << std::setw(12) << "pool/cv/io" << std::setw(9) << "fps" << std::setw(9) << "p50 ms" << std::setw(9) << "p95 ms"
+         << std::setw(9) << "p99 ms" << std::setw(10) << "mean IoU" << (sAllocTracking ? "tracked  allocs/frame" : "tracked") << endl;
+
+    for (const auto &scenario : scenarios)
+    {
+        std::string path = (std::filesystem::path(workdir) / "object_highlighter_bench.avi").string();
+
+        GroundTruth groundTruth;
+        if (!generateVideo(scenario, path, seed, groundTruth))
+        {
+            std::cerr << "Error: Could not write generated video: " << path << endl;
+            return 1;
+        }
+
+        std::string resolution = std::to_string(scenario.resolution.width) + "x" + std::to_string(scenario.resolution.height);
+        for (const auto &budget : budgets)
+        {
+            ScenarioResult result = runPipeline(path, groundTruth, budget, searchWindowMode);
+
+            std::string split = std::to_string(budget.pool) + "/" + std::to_string(budget.opencv) + "/" + std::to_string(budget.codec);
+            cout << std::fixed << std::setprecision(2) << std::setw(11) << resolution << std::setw(9) << scenario.objects
+                 << std::setw(6) << scenario.objectSize << std::setw(7) << scenario.speed << std::setw(12) << split
+                 << std::setw(9) << result.fps << std::setw(9) << result.latencyP50 << std::setw(9) << result.latencyP95
+                 << std::setw(9) << result.latencyP99 << std::setw(10) << result.meanIoU;
+            if (sAllocTracking)
+            {
+                cout << std::setw(9) << result.trackedRatio << result.allocationsPerFrame;
+            }
+            else
+            {
+                cout << result.trackedRatio;
+            }
+            cout << endl;
+
+            if (csv.is_open())
+            {
+                csv << scenario.resolution.width << "," << scenario.resolution.height << "," << scenario.objects << ","
+                    << scenario.objectSize << "," << scenario.speed << "," << budget.total << "," << budget.pool << ","
+                    << budget.opencv << "," << budget.codec << "," << result.frames << "," << result.seconds << ","
+                    << result.fps << "," << result.latencyP50 << "," << result.latencyP95 << "," << result.latencyP99 << ","
+                    << result.meanIoU << "," << result.trackedRatio;
+                if (sAllocTracking)
+                {
+                    csv << "," << result.allocationsPerFrame << "," << result.allocatedBytesPerFrame;
+                }
+                csv << endl;
+            }
+        }
+        std::filesystem::remove(path);
+    }
+
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include "ThreadPool.h"
+#include "ThreadSafeQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Settings shared by all benchmarks
+struct Settings
+{
+    std::string label{"baseline"};
+    int iterations{20000};
+};
+
+// Print one CSV row of results
+static void report(const Settings &settings, const std::string &benchmark, int threads, int capacity, int jobs,
+                   long long operations, Clock::duration elapsed)
+{
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    double nsPerOp = operations > 0 ? ns / operations : 0.0;
+    double opsPerSec = ns > 0.0 ? operations * 1e9 / ns : 0.0;
+
+    std::cout << settings.label << "," << benchmark << "," << threads << "," << capacity << "," << jobs << ","
+              << operations << "," << nsPerOp << "," << opsPerSec << std::endl;
+}
+
+// Round trip of one item between two threads through a pair of queues
+static void benchPingPong(const Settings &settings)
+{
+    std::stop_source stopSource;
+    std::stop_token st = stopSource.get_token();
+    ThreadSafeQueue<int> ping(1);
+    ThreadSafeQueue<int> pong(1);
+
+    std::jthread echo([&]
+                      {
+                          while (!st.stop_requested())
+                          {
+                              std::optional<int> value = ping.waitAndPop(st);
+                              if (value.has_value())
+                              {
+                                  pong.push(*value, st);
+                              }
+                          } });
+
+    auto start = Clock::now();
+    for (int i = 0; i < settings.iterations; ++i)
+    {
+        ping.push(i, st);
+        pong.waitAndPop(st);
+    }
+    auto elapsed = Clock::now() - start;
+
+    stopSource.request_stop();
+    report(settings, "queue_round_trip", 2, 1, 0, settings.iterations, elapsed);
+}
+
+// Single producer and single consumer streaming items through one queue
+static void benchThroughput(const Settings &settings, int capacity)
+{
+    std::stop_source stopSource;
+    std::stop_token st = stopSource.get_token();
+    ThreadSafeQueue<int> queue(capacity);
+    const int items = settings.iterations * 10;
+
+    auto start = Clock::now();
+    std::jthread producer([&]
+                          {
+                              for (int i = 0; i < items; ++i)
+                              {
+                                  queue.push(i, st);
+                              } });
+
+    for (int i = 0; i < items; ++i)
+    {
+        queue.waitAndPop(st);
+    }
+    auto elapsed = Clock::now() - start;
+
+    producer.join();
+    report(settings, "queue_throughput", 2, capacity, 0, items, elapsed);
+}
+
+// Cost of clear() while producers and a consumer are hammering the queue
+static void benchClear(const Settings &settings, int producers)
+{
+    std::stop_source stopSource;
+    std::stop_token st = stopSource.get_token();
+    constexpr int capacity = 8;
+    ThreadSafeQueue<int> queue(capacity);
+
+    std::vector<std::jthread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&]
+                             {
+                                 int i = 0;
+                                 while (!st.stop_requested())
+                                 {
+                                     queue.push(i++, st);
+                                 } });
+    }
+    threads.emplace_back([&]
+                         {
+                             while (!st.stop_requested())
+                             {
+                                 queue.waitAndPop(st);
+                             } });
+
+    const int clears = settings.iterations / 10;
+    Clock::duration elapsed{0};
+    for (int i = 0; i < clears; ++i)
+    {
+        auto start = Clock::now();
+        queue.clear();
+        elapsed += Clock::now() - start;
+
+        // Let the queue refill between clears
+        std::this_thread::yield();
+    }
+
+    stopSource.request_stop();
+    threads.clear();
+    report(settings, "queue_clear", producers + 1, capacity, 0, clears, elapsed);
+}
+
+// Overhead of submitting a batch of tiny jobs and waiting for all of them
+static void benchPool(const Settings &settings, int threads, int jobs)
+{
+    std::stop_source stopSource;
+    std::atomic<int> counter{0};
+    const int batches = std::max(1, settings.iterations / jobs);
+
+    Clock::duration elapsed{0};
+    {
+        ThreadPool pool(threads, stopSource.get_token());
+
+        auto start = Clock::now();
+        for (int b = 0; b < batches; ++b)
+        {
+            for (int j = 0; j < jobs; ++j)
+            {
+                pool.submit([&counter]
+                            { counter.fetch_add(1, std::memory_order_relaxed); });
+            }
+
+            if (!pool.waitAll(std::chrono::seconds(10)))
+            {
+                std::cerr << "Warning: Thread pool batch did not complete within the timeout." << std::endl;
+            }
+        }
+        elapsed = Clock::now() - start;
+
+        stopSource.request_stop();
+    }
+
+    // One operation is one submitted and completed batch
+    report(settings, "pool_submit_wait", threads, 0, jobs, batches, elapsed);
+}
+
+int main(int argc, char *argv[])
+{
+    Settings settings;
+
+    // Parse "--label=name" and "--iterations=n"
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--label=", 0) == 0)
+        {
+            settings.label = arg.substr(std::strlen("--label="));
+        }
+        else if (arg.rfind("--iterations=", 0) == 0)
+        {
+            settings.iterations = std::max(10, std::stoi(arg.substr(std::strlen("--iterations="))));
+        }
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--label=name] [--iterations=n]" << std::endl;
+            std::cout << "Writes CSV results to stdout" << std::endl;
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    std::cout << "label,benchmark,threads,capacity,jobs,operations,ns_per_op,ops_per_sec" << std::endl;
+
+    benchPingPong(settings);
+
+    for (int capacity : {1, 2, 8, 64, 1024})
+    {
+        benchThroughput(settings, capacity);
+    }
+
+    for (int producers : {1, 2, 4})
+    {
+        benchClear(settings, producers);
+    }
+
+    for (int threads : {1, 2, 4, 8, 16})
+    {
+        for (int jobs : {1, 10, 100, 1000})
+        {
+            benchPool(settings, threads, jobs);
+        }
+    }
+
+    return 0;
+}
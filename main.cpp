@@ -1,17 +1,59 @@
+#include "Affinity.h"
 #include "ObjectHighlighter.h"
+#include "Scenario.h"
+#include "SearchWindow.h"
 #include "VideoProcessor.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
 
 #include "opencv2/core.hpp"
+#include "opencv2/imgcodecs.hpp"
 
 // Command line argument keys
 const char *keys =
     "{help h usage ?  |             | print this message            }"
     "{@video          |             | video file path (required)    }"
     "{output o        | output.mp4  | output video file path        }"
-    "{format f        | mp4v        | video format                  }";
+    "{format f        | mp4v        | video format                  }"
+    "{budget b        | 512         | in-flight frame memory in MB, 0 for unlimited }"
+    "{shm             |             | publish frames to this POSIX shared memory name (e.g. /highlighter) }"
+    "{preview-scale   | 1.0         | scale of the displayed preview, full resolution is kept for output }"
+    "{results         |             | stream tracker boxes to this file, binary columnar or JSON Lines if it ends in .jsonl }"
+    "{export          | full        | what saving writes: full (annotated frames), crops (one video per object) or both }"
+    "{crop-dir        | crops       | directory of the object crop videos }"
+    "{crop-size       | 128         | side of the square object crops in pixels }"
+    "{live            |             | treat the source as live: newest frame only, no seeking (automatic for devices and pipes) }"
+    "{cache-budget    | 0           | disk space in MB for cached decoded frames, 0 disables }"
+    "{cache-dir       | /var/tmp    | directory of the frame cache file }"
+    "{search-window   | off         | what trackers search in: off (whole frame), view (padded window) or gather (window copied to a contiguous buffer) }"
+    "{threads         | 0           | cores to divide between the stages, the tracker pool and OpenCV, 0 for all }"
+    "{opencv-threads  | -1          | OpenCV's share of the cores, -1 to choose it automatically }"
+    "{numa-node       | -1          | lay the stages and the pool out on the cores of this NUMA node, -1 leaves threads floating }"
+    "{pin-reader      |             | cores of the reader stage as a cpulist, e.g. 0 }"
+    "{pin-tracker     |             | cores of the tracker stage, default the pool's cores }"
+    "{pin-output      |             | cores of the output stage }"
+    "{pin-pool        |             | cores of the tracker pool, e.g. 2-15 }"
+    "{snapshot-dir    | .           | directory of snapshots ('o') and bursts }"
+    "{snapshot-format | jpg         | image format of snapshots, e.g. jpg, png or webp }"
+    "{snapshot-quality | 95         | snapshot quality 0-100, for png lower values compress harder }"
+    "{burst           |             | save every burst-step-th frame in this range during playback, e.g. 100-500 }"
+    "{burst-step      | 10          | frames between the snapshots of a burst, also for bursts started with 'b' }"
+    "{scenario        |             | scripted actions to replay by frame index, see Scenario.h }"
+    "{scenario-report |             | CSV file for the timing of each scripted action }"
+    "{luma            |             | track on the decoder's luma plane, converting to BGR only for shown or saved frames }"
+    "{headless        |             | no windows or keyboard input, play the video through once }"
+    "{tracking-budget-ms | 0         | tracking time per frame in ms, later updates are deferred to the next frame, 0 for unlimited }"
+    "{latency-target  | 0           | latency to hold in ms by lowering quality under load, 0 disables }"
+    "{max-stride      | 20          | most frames between tracker updates under load }"
+    "{min-preview-scale | 0.25      | smallest preview scale under load }"
+    "{max-patch-area  | 6400        | KCF feature patch area in pixels at full quality }"
+    "{min-patch-area  | 1024        | smallest KCF feature patch area under load }";
 
 int main(int argc, char *argv[])
 {
@@ -33,6 +75,70 @@ int main(int argc, char *argv[])
     std::string outputPath = parser.get<std::string>("output");
     std::string format = parser.get<std::string>("format");
 
+    // Get the memory budget for frames in flight
+    int budget = parser.get<int>("budget");
+
+    // Get the shared memory name for frame output
+    std::string shmName = parser.get<std::string>("shm");
+
+    // Get the scale of the displayed preview
+    double previewScale = parser.get<double>("preview-scale");
+
+    // Get the results file
+    std::string resultsPath = parser.get<std::string>("results");
+
+    // Get the export settings
+    std::string exportText = parser.get<std::string>("export");
+    std::string cropDir = parser.get<std::string>("crop-dir");
+    int cropSize = parser.get<int>("crop-size");
+
+    // Check if the source is forced to be live
+    bool live = parser.has("live");
+
+    // Get the frame cache settings
+    int cacheBudget = parser.get<int>("cache-budget");
+    std::string cacheDir = parser.get<std::string>("cache-dir");
+
+    // Get the search window mode
+    std::string searchWindowText = parser.get<std::string>("search-window");
+
+    // Get the thread budget
+    int threads = parser.get<int>("threads");
+    int opencvThreads = parser.get<int>("opencv-threads");
+
+    // Get the thread pinning settings
+    int numaNode = parser.get<int>("numa-node");
+    std::string pinReader = parser.get<std::string>("pin-reader");
+    std::string pinTracker = parser.get<std::string>("pin-tracker");
+    std::string pinOutput = parser.get<std::string>("pin-output");
+    std::string pinPool = parser.get<std::string>("pin-pool");
+
+    // Get the snapshot and burst settings
+    SnapshotSettings snapshotSettings;
+    snapshotSettings.directory = parser.get<std::string>("snapshot-dir");
+    snapshotSettings.format = parser.get<std::string>("snapshot-format");
+    snapshotSettings.quality = parser.get<int>("snapshot-quality");
+    std::string burstText = parser.get<std::string>("burst");
+    int burstStep = parser.get<int>("burst-step");
+
+    // Get the scenario files
+    std::string scenarioPath = parser.get<std::string>("scenario");
+    std::string scenarioReport = parser.get<std::string>("scenario-report");
+
+    // Check if trackers work on luma and if the run is headless
+    bool luma = parser.has("luma");
+    bool headless = parser.has("headless");
+
+    // Get the tracking time budget per frame
+    double trackingBudgetMs = parser.get<double>("tracking-budget-ms");
+
+    // Get the quality-of-service bounds
+    double latencyTarget = parser.get<double>("latency-target");
+    int maxStride = parser.get<int>("max-stride");
+    double minPreviewScale = parser.get<double>("min-preview-scale");
+    int maxPatchArea = parser.get<int>("max-patch-area");
+    int minPatchArea = parser.get<int>("min-patch-area");
+
     // Check if the parser is correctly initialized
     // Needs to happen after get calls as they set the error flag
     if (!parser.check())
@@ -41,8 +147,105 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    // Check the export mode
+    ExportMode exportMode = ExportMode::Full;
+    if (!exportModeParse(exportText, exportMode))
+    {
+        std::cerr << "Error: Unknown export mode: " << exportText << std::endl;
+        return 1;
+    }
+
+    // Check the search window mode
+    SearchWindowMode searchWindowMode = SearchWindowMode::Off;
+    if (!searchWindowModeParse(searchWindowText, searchWindowMode))
+    {
+        std::cerr << "Error: Unknown search window mode: " << searchWindowText << std::endl;
+        return 1;
+    }
+
+    // Check the snapshot format and the burst
+    if (!cv::haveImageWriter("snapshot." + snapshotSettings.format))
+    {
+        std::cerr << "Error: Unsupported snapshot format: " << snapshotSettings.format << std::endl;
+        return 1;
+    }
+    BurstRange burst{-1, -1, std::max(burstStep, 1)};
+    if (!burstText.empty() && !burstRangeParse(burstText, burst.step, burst))
+    {
+        std::cerr << "Error: Invalid burst range: " << burstText << std::endl;
+        return 1;
+    }
+
+    // Load the scenario
+    ScenarioSettings scenario;
+    scenario.reportPath = scenarioReport;
+    if (!scenarioPath.empty() && !scenarioLoad(scenarioPath, scenario.actions))
+    {
+        return 1;
+    }
+
+    // Build the thread layout, a NUMA node gives the defaults and explicit lists override them
+    AffinityLayout layout;
+    if (numaNode >= 0)
+    {
+        std::vector<int> nodeCpus;
+        if (!numaNodeCpus(numaNode, nodeCpus))
+        {
+            std::cerr << "Error: Unknown NUMA node: " << numaNode << std::endl;
+            return 1;
+        }
+        layout = affinityForCpus(nodeCpus);
+    }
+    for (auto [text, cpus] : {std::pair{&pinReader, &layout.reader}, std::pair{&pinTracker, &layout.tracker},
+                              std::pair{&pinOutput, &layout.output}, std::pair{&pinPool, &layout.pool}})
+    {
+        if (!text->empty() && !cpuListParse(*text, *cpus))
+        {
+            std::cerr << "Error: Invalid cpulist: " << *text << std::endl;
+            return 1;
+        }
+    }
+    // The tracker stage follows the pool unless placed explicitly
+    if (pinTracker.empty() && !pinPool.empty())
+    {
+        layout.tracker = layout.pool;
+    }
+    bool pinned = !layout.reader.empty() || !layout.tracker.empty() || !layout.output.empty() || !layout.pool.empty();
+
+    // A layout that places every part confines the pipeline to its cores, divide those instead of the machine's
+    // Threads started from here on (OpenCV's workers, the decoder's threads) inherit the main thread's cores,
+    // so they stay on the layout too instead of crossing sockets
+    int budgetCores = std::max(threads, 0);
+    if (pinned)
+    {
+        std::vector<int> layoutCpus = affinityCpus(layout);
+        bool complete = !layout.reader.empty() && !layout.tracker.empty() && !layout.output.empty() && !layout.pool.empty();
+        if (complete)
+        {
+            int layoutCores = static_cast<int>(layoutCpus.size());
+            budgetCores = budgetCores > 0 ? std::min(budgetCores, layoutCores) : layoutCores;
+            std::cout << "Thread budget: dividing the " << layoutCores << " cores of the layout ("
+                      << cpuListFormat(layoutCpus) << ")" << std::endl;
+            if (!threadPin(pthread_self(), layoutCpus))
+            {
+                std::cerr << "Warning: Could not pin the main thread to cores " << cpuListFormat(layoutCpus) << std::endl;
+            }
+        }
+    }
+
     // Create ObjectHighlighter instance and load the video
+    // The thread budget comes first, the decoder threads are chosen when the video is opened
     ObjectHighlighter objectHighlighter;
+    objectHighlighter.threadBudget(budgetCores, opencvThreads, static_cast<int>(layout.pool.size()));
+    if (pinned)
+    {
+        objectHighlighter.affinity(layout);
+    }
+    // Live mode, luma tracking and headless mode decide how the first frames are read, decoded and shown
+    // Live sources are opened once, without a keyframe index or frames read ahead
+    objectHighlighter.liveInput(live);
+    objectHighlighter.lumaTracking(luma);
+    objectHighlighter.headless(headless);
     if (!objectHighlighter.loadVideo(videoPath))
     {
         std::cerr << "Error: Could not open video file: " << videoPath << std::endl;
@@ -55,6 +258,39 @@ int main(int argc, char *argv[])
     // Set writer settings
     objectHighlighter.writerSettings(outputPath, format);
 
+    // Set the memory budget for frames in flight
+    objectHighlighter.memoryBudget(std::max(budget, 0));
+
+    // Set the shared memory output
+    objectHighlighter.sharedMemoryOutput(shmName);
+
+    // Set the preview scale
+    objectHighlighter.previewScale(previewScale);
+
+    // Set the results file
+    objectHighlighter.resultsOutput(resultsPath);
+
+    // Set the export mode
+    objectHighlighter.exportSettings(exportMode, cropDir, cropSize);
+
+    // Set the frame cache
+    objectHighlighter.frameCache(cacheDir, std::max(cacheBudget, 0));
+
+    // Set the search window mode
+    objectHighlighter.searchWindow(searchWindowMode);
+
+    // Set the snapshot settings
+    objectHighlighter.snapshotSettings(snapshotSettings, burst);
+
+    // Set the scripted actions
+    objectHighlighter.scenario(scenario);
+
+    // Set the tracking time budget per frame
+    objectHighlighter.trackingBudget(trackingBudgetMs);
+
+    // Set the quality-of-service bounds
+    objectHighlighter.qualityOfService(latencyTarget, maxStride, minPreviewScale, maxPatchArea, minPatchArea);
+
     // Start video playback and processing
     objectHighlighter.playVideo();
 
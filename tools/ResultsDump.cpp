@@ -0,0 +1,69 @@
+// Loader example for the binary tracking results
+// Loads a results file, prints how long that took and a summary per
+// tracker, and optionally every row as CSV
+
+#include "ResultsFormat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <results file> [--csv]" << std::endl;
+        return 1;
+    }
+
+    std::string path = argv[1];
+    bool csv = argc > 2 && std::string(argv[2]) == "--csv";
+
+    auto start = std::chrono::steady_clock::now();
+    ResultsColumns columns;
+    if (!resultsLoad(path, columns))
+    {
+        std::cerr << "Error: Could not load results file: " << path << std::endl;
+        return 1;
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (csv)
+    {
+        std::cout << "frame,id,x,y,width,height,active" << std::endl;
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            std::cout << columns.frame[i] << "," << columns.id[i] << "," << columns.x[i] << "," << columns.y[i] << ","
+                      << columns.width[i] << "," << columns.height[i] << "," << int(columns.active[i]) << "\n";
+        }
+        return 0;
+    }
+
+    // Frames and active frames of every tracker
+    struct Summary
+    {
+        int firstFrame{-1};
+        int lastFrame{-1};
+        size_t rows{0};
+        size_t activeRows{0};
+    };
+    std::map<int, Summary> trackers;
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+        Summary &summary = trackers[columns.id[i]];
+        summary.firstFrame = summary.rows == 0 ? columns.frame[i] : std::min(summary.firstFrame, columns.frame[i]);
+        summary.lastFrame = std::max(summary.lastFrame, columns.frame[i]);
+        summary.rows += 1;
+        summary.activeRows += columns.active[i];
+    }
+
+    std::cout << "Loaded " << columns.size() << " rows in " << elapsed.count() << " ms" << std::endl;
+    for (const auto &[id, summary] : trackers)
+    {
+        std::cout << "Tracker " << id << ": frames " << summary.firstFrame << " to " << summary.lastFrame << ", "
+                  << summary.rows << " rows, " << summary.activeRows << " active" << std::endl;
+    }
+    return 0;
+}
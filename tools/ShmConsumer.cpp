@@ -0,0 +1,226 @@
+// Reference consumer for the shared-memory frame output
+// Attaches to the segment, copies the newest frame whenever one is
+// published and prints its index, boxes, age and the receive rate
+
+#include "ShmProtocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Segment the consumer is attached to
+struct Attachment
+{
+    const uint8_t *data{nullptr};
+    size_t size{0};
+    ino_t inode{0};
+
+    const ShmHeader *header() const { return reinterpret_cast<const ShmHeader *>(data); }
+};
+
+// Check if the name refers to another segment than the attached one, e.g. after the producer reopened it
+static bool replaced(const std::string &name, const Attachment &attachment)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return true;
+    }
+    struct stat st;
+    bool other = fstat(fd, &st) != 0 || st.st_ino != attachment.inode;
+    close(fd);
+    return other;
+}
+
+// Unmap the segment
+static void detach(Attachment &attachment)
+{
+    if (attachment.data != nullptr)
+    {
+        munmap(const_cast<uint8_t *>(attachment.data), attachment.size);
+    }
+    attachment = Attachment();
+}
+
+// Wait for the producer to create and describe the segment, then map it
+// Returns true if successful, false if it cannot be mapped or uses another protocol version
+static bool attach(const std::string &name, Attachment &attachment)
+{
+    while (true)
+    {
+        int fd = -1;
+        while ((fd = shm_open(name.c_str(), O_RDONLY, 0)) < 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        struct stat st;
+        while (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) < sizeof(ShmHeader))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        void *mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            std::cerr << "Error: Could not map shared memory: " << name << std::endl;
+            return false;
+        }
+        attachment.data = static_cast<const uint8_t *>(mapping);
+        attachment.size = static_cast<size_t>(st.st_size);
+        attachment.inode = st.st_ino;
+
+        // A segment being replaced never gets its magic, look for the new one then
+        while (attachment.header()->magic.load(std::memory_order_acquire) != sShmMagic)
+        {
+            if (replaced(name, attachment))
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (attachment.header()->magic.load(std::memory_order_acquire) != sShmMagic)
+        {
+            detach(attachment);
+            continue;
+        }
+
+        const ShmHeader *header = attachment.header();
+        if (header->version != sShmVersion)
+        {
+            std::cerr << "Error: Unsupported protocol version " << header->version << std::endl;
+            detach(attachment);
+            return false;
+        }
+
+        std::cout << "Attached to " << name << ": " << header->width << " x " << header->height << " x "
+                  << header->channels << ", " << header->slotCount << " slots" << std::endl;
+        return true;
+    }
+}
+
+// Time without a new frame after which the consumer checks that the segment was not replaced
+constexpr std::chrono::seconds sStallCheck{1};
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " <shared memory name> [frames to receive]" << std::endl;
+        return 1;
+    }
+
+    std::string name = argv[1];
+    long long framesToReceive = argc > 2 ? std::stoll(argv[2]) : -1;
+
+    Attachment attachment;
+    if (!attach(name, attachment))
+    {
+        return 1;
+    }
+
+    std::vector<uint8_t> pixels;
+    ShmSlotHeader slotCopy;
+
+    uint64_t lastSeen = 0;
+    long long received = 0;
+    long long skipped = 0;
+    long long torn = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto lastFrame = start;
+
+    while (framesToReceive < 0 || received < framesToReceive)
+    {
+        // The producer reopened the segment, e.g. for a new frame size
+        const ShmHeader *header = attachment.header();
+        bool stalled = std::chrono::steady_clock::now() - lastFrame > sStallCheck;
+        if (header->magic.load(std::memory_order_acquire) != sShmMagic || (stalled && replaced(name, attachment)))
+        {
+            std::cout << "Segment " << name << " was replaced, attaching again" << std::endl;
+            detach(attachment);
+            if (!attach(name, attachment))
+            {
+                return 1;
+            }
+            lastSeen = 0;
+            lastFrame = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (stalled)
+        {
+            lastFrame = std::chrono::steady_clock::now();
+        }
+
+        uint64_t published = header->published.load(std::memory_order_acquire);
+        if (published == lastSeen)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+
+        // Take the newest frame
+        const uint8_t *data = attachment.data;
+        size_t pixelBytes = size_t(header->width) * header->height * header->channels;
+        pixels.resize(pixelBytes);
+        uint64_t n = published - 1;
+        const uint8_t *slot = data + header->slotsOffset + (n % header->slotCount) * header->slotStride;
+        const ShmSlotHeader *slotHeader = reinterpret_cast<const ShmSlotHeader *>(slot);
+
+        uint64_t before = slotHeader->sequence.load(std::memory_order_acquire);
+        if (before != 2 * n + 2)
+        {
+            // Already being overwritten, try again with a newer frame
+            torn += 1;
+            continue;
+        }
+
+        slotCopy.frameIndex = slotHeader->frameIndex;
+        slotCopy.timestampNs = slotHeader->timestampNs;
+        slotCopy.boxCount = std::min(slotHeader->boxCount, sShmMaxBoxes);
+        std::memcpy(slotCopy.boxes, slotHeader->boxes, sizeof(ShmBox) * slotCopy.boxCount);
+        std::memcpy(pixels.data(), slot + sizeof(ShmSlotHeader), pixelBytes);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slotHeader->sequence.load(std::memory_order_relaxed) != before)
+        {
+            torn += 1;
+            continue;
+        }
+
+        skipped += static_cast<long long>(n - lastSeen);
+        lastSeen = published;
+        received += 1;
+        lastFrame = std::chrono::steady_clock::now();
+
+        // Both processes use the same steady clock
+        long long nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+
+        std::cout << "frame " << slotCopy.frameIndex << " age " << (nowNs - slotCopy.timestampNs) / 1000 << " us boxes";
+        for (uint32_t i = 0; i < slotCopy.boxCount; ++i)
+        {
+            const ShmBox &box = slotCopy.boxes[i];
+            std::cout << " [" << box.id << ": " << box.x << "," << box.y << " " << box.width << "x" << box.height
+                      << (box.active ? "" : " inactive") << "]";
+        }
+        std::cout << std::endl;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Received " << received << " frames (" << received / elapsed.count() << " fps), skipped "
+              << skipped << ", retried " << torn << std::endl;
+
+    detach(attachment);
+    return 0;
+}